@@ -0,0 +1,2084 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "StageProfiler.h"
+
+using namespace juce;
+
+// The instruction set variants below must round alike, so multiplies and adds
+// are never contracted into FMAs, which both GCC and clang otherwise do
+// wherever the target has them. GCC takes it per function, see
+// DAMNBASSBOOST_KERNEL_TARGET.
+#if JUCE_CLANG
+ #pragma clang fp contract(off)
+#endif
+
+// Kernels built for several x86 instruction sets in one binary, selected at
+// run time; see BassBoostInstructionSet.
+#if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG) && ! defined(DAMNBASSBOOST_NO_ISA_DISPATCH)
+ #define DAMNBASSBOOST_ISA_DISPATCH 1
+#else
+ #define DAMNBASSBOOST_ISA_DISPATCH 0
+#endif
+
+// GCC and clang vector extensions, for the arithmetic dsp::SIMDRegister does
+// not have: division, conversion between floats and integers, and shifts.
+#if JUCE_GCC || JUCE_CLANG
+ #define DAMNBASSBOOST_VECTOR_EXTENSIONS 1
+#else
+ #define DAMNBASSBOOST_VECTOR_EXTENSIONS 0
+#endif
+
+#if JUCE_GCC
+ #define DAMNBASSBOOST_KERNEL_TARGET(isa) __attribute__((target(isa), optimize("fp-contract=off")))
+ #define DAMNBASSBOOST_KERNEL_BASELINE    __attribute__((optimize("fp-contract=off")))
+#elif JUCE_CLANG
+ #define DAMNBASSBOOST_KERNEL_TARGET(isa) __attribute__((target(isa)))
+ #define DAMNBASSBOOST_KERNEL_BASELINE
+#else
+ #define DAMNBASSBOOST_KERNEL_BASELINE
+#endif
+
+//==============================================================================
+// Plain parameter values as the user sees them (dB, ms, Hz, %).
+struct BassBoostParameters
+{
+    // Flags telling the engines which values differ from the previous block.
+    enum Change
+    {
+        preGainChanged    = 1 << 0,
+        speedChanged      = 1 << 1,
+        ratioChanged      = 1 << 2,
+        boostFreqChanged  = 1 << 3,
+        boostDriveChanged = 1 << 4,
+        amountChanged     = 1 << 5,
+        postGainChanged   = 1 << 6,
+        linkDetectorChanged = 1 << 7,
+        allChanged        = (1 << 8) - 1,
+    };
+
+    float preGain = 0.0f;
+    float speed = 1000.0f;
+    float ratio = 5.0f;
+    float boostFreq = 60.0f;
+    float boostDrive = 0.0f;
+    float amount = 50.0f;
+    float postGain = 0.0f;
+
+    // One compressor envelope for all channels, following the loudest of them.
+    bool linkDetector = false;
+
+    int getChangesFrom(const BassBoostParameters& previous) const noexcept
+    {
+        return (preGain != previous.preGain ? preGainChanged : 0)
+             | (speed != previous.speed ? speedChanged : 0)
+             | (ratio != previous.ratio ? ratioChanged : 0)
+             | (boostFreq != previous.boostFreq ? boostFreqChanged : 0)
+             | (boostDrive != previous.boostDrive ? boostDriveChanged : 0)
+             | (amount != previous.amount ? amountChanged : 0)
+             | (postGain != previous.postGain ? postGainChanged : 0)
+             | (linkDetector != previous.linkDetector ? linkDetectorChanged : 0);
+    }
+
+    // Lower ratios give a quieter compressor output, so the boost makes up for it.
+    template <typename SampleType>
+    SampleType getBoostGain() const noexcept
+    {
+        return (SampleType) amount
+             * Decibels::decibelsToGain(SampleType(102) * (SampleType(0.7) - SampleType(1) / (SampleType) ratio))
+             * SampleType(0.75);
+    }
+
+    // The dry and wet signals are mixed at half level each.
+    template <typename SampleType>
+    SampleType getPostGainDecibels() const noexcept
+    {
+        return (SampleType) postGain + SampleType(6);
+    }
+};
+
+//==============================================================================
+// Coefficient formulas shared by the fused engine and its lookup tables. They
+// match dsp::BallisticsFilter and dsp::LadderFilter exactly.
+namespace BassBoostCoefficients
+{
+    template <typename SampleType>
+    SampleType getBallisticsCte(SampleType timeMs, double sampleRate) noexcept
+    {
+        return timeMs < static_cast<SampleType>(1.0e-3) ? 0
+                                                        : static_cast<SampleType>(std::exp(-2.0 * MathConstants<double>::pi * 1000.0 / (timeMs * sampleRate)));
+    }
+
+    template <typename SampleType>
+    SampleType getCutoffTransform(SampleType cutoffFreqHz, double sampleRate) noexcept
+    {
+        const auto cutoffFreqScaler = SampleType(-2.0 * MathConstants<double>::pi) / (SampleType) sampleRate;
+        return std::exp(cutoffFreqHz * cutoffFreqScaler);
+    }
+
+    // How long the output keeps changing after the input stops: the detector
+    // release and the ladder filter's ring, each until it has fallen by 120 dB.
+    // The ballistics time constant is speed / 2pi ms; the four ladder poles
+    // each have a time constant of 1 / (2pi cutoff) s.
+    template <typename SampleType>
+    double getTailLengthSeconds(SampleType speedMs, SampleType cutoffFreqHz) noexcept
+    {
+        const auto decay = std::log(1.0e6);
+        const auto release = decay * (double) speedMs / (2000.0 * MathConstants<double>::pi);
+        const auto ring = 4.0 * decay / (2.0 * MathConstants<double>::pi * jmax(1.0, (double) cutoffFreqHz));
+
+        return release + ring;
+    }
+
+    // Same tanh table as dsp::LadderFilter's saturator, shared by all instances.
+    template <typename SampleType>
+    const dsp::LookupTableTransform<SampleType>& getSaturationTable()
+    {
+        static const dsp::LookupTableTransform<SampleType> table{ [](SampleType x) { return std::tanh(x); },
+                                                                  SampleType(-5), SampleType(5), 128 };
+        return table;
+    }
+}
+
+//==============================================================================
+// Accuracy of the transcendental functions in the per-sample path.
+enum class BassBoostQuality
+{
+    // The tanh table of dsp::LadderFilter and std::pow, as the chain engine
+    // computes them. The fused engine sums in another order, so its output
+    // is within the -96 dB of DamnBassBoostBench --verify, not bit-identical.
+    reference,
+    // Rational tanh and polynomial pow: within 1e-4 of std::tanh (closer
+    // than the table) and 2e-6 (float) or 3e-7 (double) relative of std::pow.
+    fast,
+    // Lower orders: within 1.4e-3 of std::tanh and 3.5e-4 relative of
+    // std::pow, i.e. 0.003 dB of compressor gain.
+    draft,
+};
+
+//==============================================================================
+// Instruction set the fused engine's per-sample kernel is compiled for. The
+// baseline is what the whole binary targets (SSE2 on x86-64, NEON on arm64);
+// on x86 with GCC or clang the kernel is also built for AVX2 and AVX-512F and
+// the best one the CPU supports is picked when the engine is prepared. Every
+// variant produces the same output bit for bit. The fused engine keeps the
+// width of dsp::SIMDRegister in all of them, as its lanes are the channels of
+// one signal, so its wider variants differ only in code generation and VEX
+// encoding and run within a few percent of the baseline. MultiStreamBassBoost,
+// whose lanes are independent streams, runs 8 lanes in its AVX2 variant and
+// 16 in its AVX-512 one, which is where the variants pay off.
+//
+// MSVC dispatch is out of scope: MSVC has no per-function target attribute,
+// so each variant would need a translation unit of its own built with
+// /arch:AVX2 or /arch:AVX512, which this header-only layout does not have.
+// The Visual Studio and Xcode (arm64) builds run the baseline kernel.
+enum class BassBoostInstructionSet
+{
+    automatic,
+    baseline,
+    avx2,
+    avx512,
+};
+
+namespace BassBoostDispatch
+{
+    inline bool isAvailable(BassBoostInstructionSet instructionSet)
+    {
+        switch (instructionSet)
+        {
+            case BassBoostInstructionSet::automatic:
+            case BassBoostInstructionSet::baseline:  return true;
+           #if DAMNBASSBOOST_ISA_DISPATCH
+            case BassBoostInstructionSet::avx2:      return SystemStats::hasAVX2();
+            case BassBoostInstructionSet::avx512:    return SystemStats::hasAVX512F();
+           #endif
+            default:                                 return false;
+        }
+    }
+
+    // The best available set for automatic; unavailable requests fall back to the baseline.
+    inline BassBoostInstructionSet resolve(BassBoostInstructionSet requested)
+    {
+        if (requested == BassBoostInstructionSet::automatic)
+        {
+            for (auto candidate : { BassBoostInstructionSet::avx512, BassBoostInstructionSet::avx2 })
+                if (isAvailable(candidate))
+                    return candidate;
+
+            return BassBoostInstructionSet::baseline;
+        }
+
+        return isAvailable(requested) ? requested : BassBoostInstructionSet::baseline;
+    }
+
+    inline String getName(BassBoostInstructionSet instructionSet)
+    {
+        switch (instructionSet)
+        {
+            case BassBoostInstructionSet::automatic: return "auto";
+            case BassBoostInstructionSet::avx2:      return "avx2";
+            case BassBoostInstructionSet::avx512:    return "avx512";
+            case BassBoostInstructionSet::baseline:
+            default:
+               #if JUCE_ARM && JUCE_USE_SIMD
+                return "neon";
+               #elif JUCE_INTEL
+                return "sse2";
+               #else
+                return "baseline";
+               #endif
+        }
+    }
+}
+
+#if DAMNBASSBOOST_VECTOR_EXTENSIONS
+//==============================================================================
+// numLanes values of SampleType as a vector extension type, and the integers
+// of the same width that its comparisons give. The compiler maps them to the
+// registers of the instruction set the calling function is built for.
+template <typename SampleType, size_t numLanes>
+struct BassBoostVector;
+
+template <> struct BassBoostVector<float, 4>  { typedef float Type __attribute__((vector_size(16)));  typedef int32 Bits __attribute__((vector_size(16))); };
+template <> struct BassBoostVector<float, 8>  { typedef float Type __attribute__((vector_size(32)));  typedef int32 Bits __attribute__((vector_size(32))); };
+template <> struct BassBoostVector<float, 16> { typedef float Type __attribute__((vector_size(64)));  typedef int32 Bits __attribute__((vector_size(64))); };
+template <> struct BassBoostVector<double, 2> { typedef double Type __attribute__((vector_size(16))); typedef int64 Bits __attribute__((vector_size(16))); };
+template <> struct BassBoostVector<double, 4> { typedef double Type __attribute__((vector_size(32))); typedef int64 Bits __attribute__((vector_size(32))); };
+template <> struct BassBoostVector<double, 8> { typedef double Type __attribute__((vector_size(64))); typedef int64 Bits __attribute__((vector_size(64))); };
+#endif
+
+//==============================================================================
+// Stand-ins for tanh and pow used by the fast and draft qualities. log2 and
+// exp2 split off the exponent bits and fit the rest with Chebyshev polynomials;
+// tanh uses Pade approximants. DamnBassBoostBench --accuracy measures them.
+// The SIMD paths evaluate them on whole registers (see Vectorised).
+namespace BassBoostApproximations
+{
+    template <typename SampleType>
+    struct FloatBits;
+
+    template <>
+    struct FloatBits<float>
+    {
+        using Integer = int32;
+        static constexpr int mantissaBits = 23;
+        static constexpr Integer bias = 127;
+    };
+
+    template <>
+    struct FloatBits<double>
+    {
+        using Integer = int64;
+        static constexpr int mantissaBits = 52;
+        static constexpr Integer bias = 1023;
+    };
+
+    // For x >= 0. The mantissa m in [1, 2) goes through log2(m) = s * P(s^2)
+    // with s = (m - 1) / (m + 1); zero and denormals give -bias.
+    template <typename SampleType>
+    JUCE_FORCEINLINE SampleType log2(SampleType x, BassBoostQuality quality) noexcept
+    {
+        using Bits = FloatBits<SampleType>;
+        using Integer = typename Bits::Integer;
+
+        Integer bits;
+        std::memcpy(&bits, &x, sizeof(x));
+
+        const auto exponent = (SampleType) ((bits >> Bits::mantissaBits) - Bits::bias);
+        bits = (bits & ((Integer(1) << Bits::mantissaBits) - 1)) | (Bits::bias << Bits::mantissaBits);
+
+        SampleType m;
+        std::memcpy(&m, &bits, sizeof(m));
+
+        const auto s = (m - SampleType(1)) / (m + SampleType(1));
+        const auto u = s * s;
+
+        if (quality == BassBoostQuality::draft)
+            return exponent + s * (SampleType(2.88442305308) + u * SampleType(1.03072692238));
+
+        return exponent + s * (SampleType(2.8853896205) + u * (SampleType(0.961929162223)
+                                                        + u * (SampleType(0.571208926269) + u * SampleType(0.493453920397))));
+    }
+
+    // Clamped to the normal range. The fraction f in [0, 1) goes through a
+    // polynomial, the integer part into the exponent bits.
+    template <typename SampleType>
+    JUCE_FORCEINLINE SampleType exp2(SampleType x, BassBoostQuality quality) noexcept
+    {
+        using Bits = FloatBits<SampleType>;
+        using Integer = typename Bits::Integer;
+
+        x = jlimit(SampleType(1 - Bits::bias), SampleType(Bits::bias), x);
+
+        auto integer = (Integer) x;
+
+        if ((SampleType) integer > x)
+            --integer;
+
+        const auto f = x - (SampleType) integer;
+        SampleType p;
+
+        if (quality == BassBoostQuality::draft)
+            p = SampleType(0.999900288173) + f * (SampleType(0.696324771092) + f * (SampleType(0.224693155764) + f * SampleType(0.0789672570422)));
+        else
+            p = SampleType(0.99999989835) + f * (SampleType(0.693154489663) + f * (SampleType(0.240141818201)
+                                          + f * (SampleType(0.0558603370773) + f * (SampleType(0.0089495904233) + f * SampleType(0.00189375405822)))));
+
+        const auto bits = (integer + Bits::bias) << Bits::mantissaBits;
+        SampleType scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+
+        return p * scale;
+    }
+
+    // For x >= 0
+    template <typename SampleType>
+    JUCE_FORCEINLINE SampleType pow(SampleType x, SampleType y, BassBoostQuality quality) noexcept
+    {
+        return exp2(y * log2(x, quality), quality);
+    }
+
+    // Over [-5, 5] like the table it stands in for, and clipped to [-1, 1].
+    template <typename SampleType>
+    JUCE_FORCEINLINE SampleType tanh(SampleType x, BassBoostQuality quality) noexcept
+    {
+        x = jlimit(SampleType(-5), SampleType(5), x);
+        const auto x2 = x * x;
+
+        if (quality == BassBoostQuality::draft)
+            return jlimit(SampleType(-1), SampleType(1), x * (SampleType(945) + x2 * (SampleType(105) + x2))
+                                                       / (SampleType(945) + x2 * (SampleType(420) + x2 * SampleType(15))));
+
+        return jlimit(SampleType(-1), SampleType(1), dsp::FastMathApproximations::tanh(x));
+    }
+
+   #if DAMNBASSBOOST_VECTOR_EXTENSIONS
+    //==============================================================================
+    // The functions above on numLanes values at once, with the same operations
+    // in the same order, so every lane matches the scalar result bit for bit.
+    template <typename SampleType, size_t numLanes>
+    struct Vectorised
+    {
+        using Vector = typename BassBoostVector<SampleType, numLanes>::Type;
+        using Bits = typename BassBoostVector<SampleType, numLanes>::Bits;
+        using Integer = typename FloatBits<SampleType>::Integer;
+
+        static constexpr int mantissaBits = FloatBits<SampleType>::mantissaBits;
+        static constexpr Integer bias = FloatBits<SampleType>::bias;
+
+        static JUCE_FORCEINLINE Vector log2(Vector x, BassBoostQuality quality) noexcept
+        {
+            auto bits = (Bits) x;
+
+            const auto exponent = __builtin_convertvector((bits >> mantissaBits) - bias, Vector);
+            bits = (bits & ((Integer(1) << mantissaBits) - 1)) | (bias << mantissaBits);
+
+            const auto m = (Vector) bits;
+            const auto s = (m - SampleType(1)) / (m + SampleType(1));
+            const auto u = s * s;
+
+            if (quality == BassBoostQuality::draft)
+                return exponent + s * (SampleType(2.88442305308) + u * SampleType(1.03072692238));
+
+            return exponent + s * (SampleType(2.8853896205) + u * (SampleType(0.961929162223)
+                                                            + u * (SampleType(0.571208926269) + u * SampleType(0.493453920397))));
+        }
+
+        static JUCE_FORCEINLINE Vector exp2(Vector x, BassBoostQuality quality) noexcept
+        {
+            x = limit(SampleType(1 - bias), SampleType(bias), x);
+
+            // Truncated, then one less where that rounded up: comparisons give -1 for true
+            auto integer = __builtin_convertvector(x, Bits);
+            integer += (Bits) (__builtin_convertvector(integer, Vector) > x);
+
+            const auto f = x - __builtin_convertvector(integer, Vector);
+            Vector p;
+
+            if (quality == BassBoostQuality::draft)
+                p = SampleType(0.999900288173) + f * (SampleType(0.696324771092) + f * (SampleType(0.224693155764) + f * SampleType(0.0789672570422)));
+            else
+                p = SampleType(0.99999989835) + f * (SampleType(0.693154489663) + f * (SampleType(0.240141818201)
+                                              + f * (SampleType(0.0558603370773) + f * (SampleType(0.0089495904233) + f * SampleType(0.00189375405822)))));
+
+            return p * (Vector) ((integer + bias) << mantissaBits);
+        }
+
+        static JUCE_FORCEINLINE Vector pow(Vector x, Vector y, BassBoostQuality quality) noexcept
+        {
+            return exp2(y * log2(x, quality), quality);
+        }
+
+        static JUCE_FORCEINLINE Vector tanh(Vector x, BassBoostQuality quality) noexcept
+        {
+            x = limit(SampleType(-5), SampleType(5), x);
+            const auto x2 = x * x;
+
+            if (quality == BassBoostQuality::draft)
+                return limit(SampleType(-1), SampleType(1), x * (SampleType(945) + x2 * (SampleType(105) + x2))
+                                                          / (SampleType(945) + x2 * (SampleType(420) + x2 * SampleType(15))));
+
+            // dsp::FastMathApproximations::tanh
+            const auto numerator = x * (SampleType(135135) + x2 * (SampleType(17325) + x2 * (SampleType(378) + x2)));
+            const auto denominator = SampleType(135135) + x2 * (SampleType(62370) + x2 * (SampleType(3150) + SampleType(28) * x2));
+
+            return limit(SampleType(-1), SampleType(1), numerator / denominator);
+        }
+
+    private:
+        // jlimit in every lane
+        static JUCE_FORCEINLINE Vector limit(SampleType lower, SampleType upper, Vector x) noexcept
+        {
+            const auto lowers = lower - Vector {};
+            const auto uppers = upper - Vector {};
+
+            return select((Bits) (x < lowers), lowers, select((Bits) (uppers < x), uppers, x));
+        }
+
+        static JUCE_FORCEINLINE Vector select(Bits mask, Vector a, Vector b) noexcept
+        {
+            return (Vector) (((Bits) a & mask) | ((Bits) b & ~mask));
+        }
+    };
+   #endif
+}
+
+#if JUCE_USE_SIMD
+//==============================================================================
+// Building blocks for the SIMD paths, which keep one channel or stream per
+// lane of a dsp::SIMDRegister, or of a wider register with the same interface
+// (see BassBoostWideRegister). They do the same arithmetic as the scalar code.
+// The fast and draft approximations run on the whole register; std::pow and
+// the tanh table of the reference quality have no vector form that rounds
+// alike, and neither has anything without vector extensions (MSVC), so those
+// go lane by lane.
+namespace BassBoostLanes
+{
+    // Applies a scalar function lane by lane, for the steps that have no SIMD form.
+    template <typename Register, typename Function>
+    JUCE_FORCEINLINE Register map(Register x, Register y, Function&& function) noexcept
+    {
+        using SampleType = typename Register::ElementType;
+
+        alignas(alignof(Register)) SampleType xs[Register::SIMDNumElements], ys[Register::SIMDNumElements];
+        x.copyToRawArray(xs);
+        y.copyToRawArray(ys);
+
+        for (size_t l = 0; l < Register::SIMDNumElements; ++l)
+            xs[l] = function(xs[l], ys[l]);
+
+        return Register::fromRawArray(xs);
+    }
+
+   #if DAMNBASSBOOST_VECTOR_EXTENSIONS
+    // Applies a function of BassBoostVector to whole registers.
+    template <typename Register, typename Function>
+    JUCE_FORCEINLINE Register mapVector(Register x, Register y, Function&& function) noexcept
+    {
+        using SampleType = typename Register::ElementType;
+        using Vector = typename BassBoostVector<SampleType, Register::SIMDNumElements>::Type;
+
+        alignas(alignof(Register)) SampleType xs[Register::SIMDNumElements], ys[Register::SIMDNumElements];
+        x.copyToRawArray(xs);
+        y.copyToRawArray(ys);
+
+        Vector xv, yv;
+        std::memcpy(&xv, xs, sizeof(Vector));
+        std::memcpy(&yv, ys, sizeof(Vector));
+
+        const auto result = function(xv, yv);
+        std::memcpy(xs, &result, sizeof(Vector));
+
+        return Register::fromRawArray(xs);
+    }
+   #endif
+
+    // Gain computer of dsp::Compressor: 1 below the threshold, (envelope / threshold)^exponent above it.
+    template <typename Register>
+    JUCE_FORCEINLINE Register getCompressorGain(Register envelope, typename Register::ElementType threshold,
+                                                typename Register::ElementType thresholdInverse, Register exponent,
+                                                BassBoostQuality quality = BassBoostQuality::reference) noexcept
+    {
+        using SampleType = typename Register::ElementType;
+
+        const auto below = Register::lessThan(envelope, Register::expand(threshold));
+       #if DAMNBASSBOOST_VECTOR_EXTENSIONS
+        using Approximations = BassBoostApproximations::Vectorised<SampleType, Register::SIMDNumElements>;
+
+        const auto above = quality == BassBoostQuality::reference
+                             ? map(envelope * thresholdInverse, exponent, [](SampleType x, SampleType y) { return std::pow(x, y); })
+                             : mapVector(envelope * thresholdInverse, exponent, [quality](auto x, auto y) { return Approximations::pow(x, y, quality); });
+       #else
+        const auto above = quality == BassBoostQuality::reference
+                             ? map(envelope * thresholdInverse, exponent, [](SampleType x, SampleType y) { return std::pow(x, y); })
+                             : map(envelope * thresholdInverse, exponent, [quality](SampleType x, SampleType y) { return BassBoostApproximations::pow(x, y, quality); });
+       #endif
+
+        return (above & ~below) + (Register::expand(SampleType(1)) & below);
+    }
+
+    // Linear interpolation in the ladder filter's tanh table, or its stand-in.
+    template <typename Register>
+    JUCE_FORCEINLINE Register saturate(Register x, BassBoostQuality quality = BassBoostQuality::reference) noexcept
+    {
+        using SampleType = typename Register::ElementType;
+
+        if (quality != BassBoostQuality::reference)
+        {
+           #if DAMNBASSBOOST_VECTOR_EXTENSIONS
+            using Approximations = BassBoostApproximations::Vectorised<SampleType, Register::SIMDNumElements>;
+            return mapVector(x, x, [quality](auto v, auto) { return Approximations::tanh(v, quality); });
+           #else
+            return map(x, x, [quality](SampleType v, SampleType) { return BassBoostApproximations::tanh(v, quality); });
+           #endif
+        }
+
+        const auto& table = BassBoostCoefficients::getSaturationTable<SampleType>();
+        x = Register::min(Register::max(x, Register::expand(SampleType(-5))), Register::expand(SampleType(5)));
+
+        return map(x, x, [&table](SampleType v, SampleType) { return table.processSampleUnchecked(v); });
+    }
+
+    // Transposes numActive channels into one register per sample frame. Unused lanes are zero.
+    template <typename Register>
+    JUCE_FORCEINLINE void load(const typename Register::ElementType* const* channels, size_t numActive, size_t offset,
+                               size_t numFrames, Register* destination) noexcept
+    {
+        alignas(alignof(Register)) typename Register::ElementType lane[Register::SIMDNumElements] = {};
+
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            for (size_t l = 0; l < numActive; ++l)
+                lane[l] = channels[l][offset + i];
+
+            destination[i] = Register::fromRawArray(lane);
+        }
+    }
+
+    template <typename Register>
+    JUCE_FORCEINLINE void store(const Register* source, typename Register::ElementType* const* channels, size_t numActive,
+                                size_t offset, size_t numFrames) noexcept
+    {
+        alignas(alignof(Register)) typename Register::ElementType lane[Register::SIMDNumElements];
+
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            source[i].copyToRawArray(lane);
+
+            for (size_t l = 0; l < numActive; ++l)
+                channels[l][offset + i] = lane[l];
+        }
+    }
+}
+#endif
+
+//==============================================================================
+// Precomputed ballistics and cutoff coefficients for every legal value of the
+// speed and boostFreq parameters at one sample rate. Parameter values are
+// snapped to their interval, so a table entry is bit-identical to computing
+// the formula; values off the grid are reported as misses and the caller
+// computes them directly. Tables are shared between instances per sample rate.
+template <typename SampleType>
+class BassBoostCoefficientTables
+{
+public:
+    BassBoostCoefficientTables(double sampleRate, const NormalisableRange<float>& speedRange, const NormalisableRange<float>& boostFreqRange)
+        : ballistics(speedRange, [sampleRate](SampleType ms) { return BassBoostCoefficients::getBallisticsCte(ms, sampleRate); }),
+          cutoffTransform(boostFreqRange, [sampleRate](SampleType hz) { return BassBoostCoefficients::getCutoffTransform(hz, sampleRate); })
+    {
+    }
+
+    bool lookupBallisticsCte(SampleType speedMs, SampleType& result) const noexcept   { return ballistics.lookup(speedMs, result); }
+    bool lookupCutoffTransform(SampleType cutoffFreqHz, SampleType& result) const noexcept { return cutoffTransform.lookup(cutoffFreqHz, result); }
+
+    size_t getSizeInBytes() const noexcept
+    {
+        return sizeof(*this) + (ballistics.values.size() + cutoffTransform.values.size()) * sizeof(SampleType);
+    }
+
+    static std::shared_ptr<const BassBoostCoefficientTables> getShared(double sampleRate,
+                                                                       const NormalisableRange<float>& speedRange,
+                                                                       const NormalisableRange<float>& boostFreqRange)
+    {
+        static CriticalSection lock;
+        static std::map<double, std::weak_ptr<const BassBoostCoefficientTables>> cache;
+
+        const ScopedLock sl(lock);
+
+        auto& entry = cache[sampleRate];
+        auto tables = entry.lock();
+
+        if (tables == nullptr)
+        {
+            tables = std::make_shared<const BassBoostCoefficientTables>(sampleRate, speedRange, boostFreqRange);
+            entry = tables;
+        }
+
+        return tables;
+    }
+
+private:
+    struct Grid
+    {
+        template <typename Function>
+        Grid(const NormalisableRange<float>& range, Function&& function)
+            : start(range.start), interval(range.interval)
+        {
+            jassert(interval > 0.0f);
+
+            auto numValues = (size_t) std::floor((range.end - range.start) / range.interval + 0.5f) + 1;
+            values.resize(numValues);
+
+            for (size_t i = 0; i < numValues; ++i)
+                values[i] = function((SampleType) getGridValue(i));
+        }
+
+        // Same arithmetic as NormalisableRange::snapToLegalValue()
+        float getGridValue(size_t index) const noexcept
+        {
+            return start + interval * (float) index;
+        }
+
+        bool lookup(SampleType value, SampleType& result) const noexcept
+        {
+            auto position = std::floor(((float) value - start) / interval + 0.5f);
+
+            if (position < 0.0f || position >= (float) values.size())
+                return false;
+
+            auto index = (size_t) position;
+
+            if ((SampleType) getGridValue(index) != value)
+                return false;
+
+            result = values[index];
+            return true;
+        }
+
+        float start, interval;
+        std::vector<SampleType> values;
+    };
+
+    Grid ballistics, cutoffTransform;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BassBoostCoefficientTables)
+};
+
+//==============================================================================
+// How ChainBassBoost sums its dry and wet paths.
+enum class BassBoostBlendMode
+{
+    // The wet path reads the block and writes a short chunk buffer that is
+    // summed back into the block in place; the dry signal is never copied.
+    // Opt-in; gives the same output as the mixer, including its 50 ms ramp
+    // from fully wet after the first prepare.
+    inPlace,
+    // dsp::DryWetMixer, which copies the whole block before the wet path runs.
+    // The release blend and the default.
+    mixer,
+};
+
+//==============================================================================
+// Oversampling of the ladder filter, whose saturator aliases once boostDrive
+// is above 0 dB. Only the ladder runs at the higher rate; the detector, gains
+// and the dry/wet sum stay at the host rate.
+enum class BassBoostOversampling
+{
+    x1,
+    x2,
+    x4,
+};
+
+//==============================================================================
+// Takes the ladder's input up to the oversampled rate and its output back
+// down, through the polyphase IIR half-band filters of dsp::Oversampling in
+// their cheaper setting: the ladder removes most of what they let through
+// before the signal comes back down. The filters delay the wet path by an
+// integer number of samples, and the dry path is delayed to match; the
+// processor reports the delay as its latency.
+template <typename SampleType>
+class BassBoostOversampler
+{
+public:
+    BassBoostOversampler() = default;
+
+    // Allocates; the oversampler is inactive at x1.
+    void prepare(BassBoostOversampling newOversampling, size_t numChannels, size_t maximumBlockSize)
+    {
+        oversampling = newOversampling;
+
+        if (oversampling == BassBoostOversampling::x1)
+        {
+            oversampler.reset();
+            delayLines.setSize(0, 0);
+            return;
+        }
+
+        oversampler = std::make_unique<dsp::Oversampling<SampleType>>(numChannels, (size_t) oversampling,
+                                                                      dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR,
+                                                                      false, true);
+        oversampler->initProcessing(maximumBlockSize);
+
+        // The IIR half-bands always delay by at least one sample.
+        jassert(getLatencySamples() > 0);
+        delayLines.setSize((int) numChannels, jmax(1, getLatencySamples()));
+        delayPositions.assign(numChannels, 0);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        if (oversampler != nullptr)
+            oversampler->reset();
+
+        delayLines.clear();
+        std::fill(delayPositions.begin(), delayPositions.end(), 0);
+    }
+
+    // Takes over the dry delay of other, prepared alike. dsp::Oversampling
+    // keeps its filter state private, so the half-bands restart from silence.
+    void copyStateFrom(const BassBoostOversampler& other) noexcept
+    {
+        jassert(delayLines.getNumChannels() == other.delayLines.getNumChannels()
+                && delayLines.getNumSamples() == other.delayLines.getNumSamples());
+
+        if (oversampler != nullptr)
+            oversampler->reset();
+
+        for (int ch = 0; ch < delayLines.getNumChannels(); ++ch)
+            delayLines.copyFrom(ch, 0, other.delayLines, ch, 0, delayLines.getNumSamples());
+
+        std::copy(other.delayPositions.begin(), other.delayPositions.end(), delayPositions.begin());
+    }
+
+    bool isActive() const noexcept { return oversampler != nullptr; }
+    int getFactor() const noexcept { return 1 << (int) oversampling; }
+
+    // The delay of the wet path in host-rate samples, 0 at x1.
+    int getLatencySamples() const noexcept
+    {
+        return oversampler != nullptr ? (int) oversampler->getLatencyInSamples() : 0;
+    }
+
+    // The oversampled copy of block, valid until processSamplesDown().
+    dsp::AudioBlock<SampleType> processSamplesUp(const dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        return oversampler->processSamplesUp(dsp::AudioBlock<const SampleType>(block));
+    }
+
+    void processSamplesDown(dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        oversampler->processSamplesDown(block);
+    }
+
+    // Delays one dry sample of a channel by getLatencySamples().
+    JUCE_FORCEINLINE SampleType delayDry(size_t channel, SampleType sample) noexcept
+    {
+        auto& position = delayPositions[channel];
+        auto* line = delayLines.getWritePointer((int) channel);
+        const auto delayed = line[position];
+
+        line[position] = sample;
+
+        if (++position == delayLines.getNumSamples())
+            position = 0;
+
+        return delayed;
+    }
+
+    void delayDry(dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        {
+            auto* samples = block.getChannelPointer(ch);
+
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+                samples[i] = delayDry(ch, samples[i]);
+        }
+    }
+
+    // True once everything still to come out of the dry delay is zero.
+    bool isDryDelaySilent() const noexcept
+    {
+        for (int ch = 0; ch < delayLines.getNumChannels(); ++ch)
+            for (int i = 0; i < delayLines.getNumSamples(); ++i)
+                if (delayLines.getSample(ch, i) != SampleType(0))
+                    return false;
+
+        return true;
+    }
+
+private:
+    BassBoostOversampling oversampling = BassBoostOversampling::x1;
+    std::unique_ptr<dsp::Oversampling<SampleType>> oversampler;
+    AudioBuffer<SampleType> delayLines;
+    std::vector<int> delayPositions;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BassBoostOversampler)
+};
+
+//==============================================================================
+// What drives the fused engine's dynamic boost.
+enum class BassBoostDetector
+{
+    // The peak ballistics and gain computer of dsp::Compressor, every sample.
+    compressor,
+    // BassBoostEnvelopeDetector: the same response at a control rate.
+    envelope,
+};
+
+//==============================================================================
+// With its threshold at -120 dB and attack equal to release, the compressor
+// the boost is built on reduces to a one-pole level follower and the gain
+// (level / threshold)^(1 / ratio - 1): the lower the input, the more boost.
+// This computes just that, once per control period of controlInterval
+// samples. The follower steps on the mean of the rectified input over the
+// period, which is what the per-sample filter averages over a period far
+// shorter than its time constant (speed / 2pi, at least 16 ms). The period is
+// read ahead within the block and the gain moves to the value at its end in
+// equal dB steps, so it does not lag. Where that value is more than about
+// 1 dB away, out of silence or on a sharp attack, the period follows every
+// sample as the compressor does.
+template <typename SampleType>
+class BassBoostEnvelopeDetector
+{
+public:
+    static constexpr int controlInterval = 32;
+
+    // About 1 dB: a period whose gain would move further follows every sample.
+    static constexpr SampleType maxPeriodRatio = SampleType(0.9);
+
+    BassBoostEnvelopeDetector() = default;
+
+    // Allocates gain rows for blocks of up to maximumBlockSize samples.
+    void prepare(double newSampleRate, size_t numChannels, size_t maximumBlockSize)
+    {
+        sampleRate = newSampleRate;
+        gains.setSize((int) numChannels, (int) jmax((size_t) 1, maximumBlockSize));
+        followers.resize(numChannels);
+        gainRows.resize(numChannels);
+        updateGainRows();
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill(followers.begin(), followers.end(), Follower());
+    }
+
+    // Takes over the followers and linking of other, prepared alike.
+    void copyStateFrom(const BassBoostEnvelopeDetector& other) noexcept
+    {
+        jassert(followers.size() == other.followers.size());
+
+        std::copy(other.followers.begin(), other.followers.end(), followers.begin());
+        linked = other.linked;
+        updateGainRows();
+    }
+
+    void setThreshold(SampleType newThreshold) noexcept
+    {
+        threshold = newThreshold;
+        thresholdInverse = SampleType(1) / threshold;
+    }
+
+    void setSpeed(SampleType speedMs) noexcept
+    {
+        sampleCte = BassBoostCoefficients::getBallisticsCte(speedMs, sampleRate);
+        periodCte = BassBoostCoefficients::getBallisticsCte(speedMs, sampleRate / controlInterval);
+    }
+
+    // A linked detector follows the loudest channel and gives every channel
+    // its gain; the state is handed over so the gain does not jump.
+    void setLinked(bool shouldLink) noexcept
+    {
+        if (shouldLink == linked || followers.empty())
+        {
+            linked = shouldLink;
+            return;
+        }
+
+        linked = shouldLink;
+
+        if (linked)
+        {
+            for (auto& follower : followers)
+                if (follower.envelope > followers[0].envelope)
+                    followers[0] = follower;
+        }
+        else
+        {
+            std::fill(followers.begin() + 1, followers.end(), followers[0]);
+        }
+
+        updateGainRows();
+    }
+
+    // Writes the gains for the block, readable through getGains() until the
+    // next call. A block that is not a whole number of periods ends with a
+    // shorter one.
+    void process(const SampleType* const* input, size_t numChannels, size_t numSamples,
+                 SampleType inputGain, SampleType exponent) noexcept
+    {
+        jassert(numChannels <= followers.size() && (int) numSamples <= gains.getNumSamples());
+
+        const auto numFollowers = linked ? jmin((size_t) 1, numChannels) : numChannels;
+
+        for (size_t start = 0; start < numSamples; start += controlInterval)
+        {
+            const auto length = jmin(numSamples - start, (size_t) controlInterval);
+            const auto cte = length == controlInterval ? periodCte : std::pow(sampleCte, (SampleType) length);
+
+            for (size_t f = 0; f < numFollowers; ++f)
+            {
+                auto& follower = followers[f];
+                auto* gainRow = gains.getWritePointer((int) f) + start;
+
+                auto sum = SampleType(0);
+
+                for (size_t i = start; i < start + length; ++i)
+                    sum += getRectified(input, f, numChannels, i);
+
+                const auto level = sum * inputGain / (SampleType) length;
+                const auto envelope = level + cte * (follower.envelope - level);
+                const auto target = getGain(envelope, exponent);
+
+                if (target < follower.gain * maxPeriodRatio || follower.gain < target * maxPeriodRatio)
+                {
+                    for (size_t i = 0; i < length; ++i)
+                    {
+                        const auto rectified = getRectified(input, f, numChannels, start + i) * inputGain;
+                        follower.envelope = rectified + sampleCte * (follower.envelope - rectified);
+                        gainRow[i] = getGain(follower.envelope, exponent);
+                    }
+
+                    follower.gain = gainRow[length - 1];
+                    continue;
+                }
+
+                follower.envelope = envelope;
+
+                const auto step = std::pow(target / follower.gain, SampleType(1) / (SampleType) length);
+                auto gain = follower.gain;
+
+                for (size_t i = 0; i < length; ++i)
+                {
+                    gain *= step;
+                    gainRow[i] = gain;
+                }
+
+                follower.gain = target;
+            }
+        }
+    }
+
+    // One row per channel; all rows are the same while linked.
+    const SampleType* const* getGains() const noexcept { return gainRows.data(); }
+
+    // The loudest follower, after the input gain.
+    SampleType getEnvelope() const noexcept
+    {
+        const auto numFollowers = linked ? jmin((size_t) 1, followers.size()) : followers.size();
+        auto envelope = SampleType(0);
+
+        for (size_t f = 0; f < numFollowers; ++f)
+            envelope = jmax(envelope, followers[f].envelope);
+
+        return envelope;
+    }
+
+private:
+    struct Follower
+    {
+        SampleType envelope = SampleType(0);
+        SampleType gain = SampleType(1);
+    };
+
+    // A linked follower takes the loudest channel.
+    JUCE_FORCEINLINE SampleType getRectified(const SampleType* const* input, size_t follower, size_t numChannels, size_t index) const noexcept
+    {
+        auto rectified = std::abs(input[follower][index]);
+
+        if (linked)
+            for (size_t ch = 1; ch < numChannels; ++ch)
+                rectified = jmax(rectified, std::abs(input[ch][index]));
+
+        return rectified;
+    }
+
+    SampleType getGain(SampleType envelope, SampleType exponent) const noexcept
+    {
+        return envelope < threshold ? SampleType(1) : std::pow(envelope * thresholdInverse, exponent);
+    }
+
+    void updateGainRows() noexcept
+    {
+        for (size_t ch = 0; ch < gainRows.size(); ++ch)
+            gainRows[ch] = gains.getReadPointer(linked ? 0 : (int) ch);
+    }
+
+    double sampleRate = 44100.0;
+    SampleType threshold = SampleType(1), thresholdInverse = SampleType(1);
+    SampleType sampleCte = SampleType(0), periodCte = SampleType(0);
+    bool linked = false;
+
+    AudioBuffer<SampleType> gains;
+    std::vector<const SampleType*> gainRows;
+    std::vector<Follower> followers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BassBoostEnvelopeDetector)
+};
+
+//==============================================================================
+// The original processing chain built from juce::dsp processors. It is the
+// reference the fused engine is checked against. It has no linked detector:
+// dsp::Compressor always follows each channel on its own.
+template <typename SampleType>
+class ChainBassBoost
+{
+public:
+    ChainBassBoost()
+    {
+        // The in-place blend starts fully wet, as dsp::DryWetMixer does, and
+        // ramps to the 50/50 mix over 50 ms after its first prepare.
+        dryVolume.setCurrentAndTargetValue(SampleType(0));
+        wetVolume.setCurrentAndTargetValue(SampleType(1));
+    }
+
+    // Takes effect on the next prepare().
+    void setBlendMode(BassBoostBlendMode newBlendMode) { blendMode = newBlendMode; }
+
+    // Takes effect on the next prepare().
+    void setOversampling(BassBoostOversampling newOversampling) { oversampling = newOversampling; }
+
+    // The delay added by oversampling the ladder, valid after prepare().
+    int getLatencySamples() const noexcept { return ladderOversampler.getLatencySamples(); }
+
+    void prepare(const dsp::ProcessSpec& spec)
+    {
+        activeBlendMode = blendMode;
+
+        preAmp.prepare(spec);
+        processors.prepare(spec);
+        postAmp.prepare(spec);
+
+        ladderOversampler.prepare(oversampling, spec.numChannels, spec.maximumBlockSize);
+
+        if (ladderOversampler.isActive())
+        {
+            const auto factor = (uint32) ladderOversampler.getFactor();
+            processors.template get<boostLpfIndex>().prepare({ spec.sampleRate * factor, spec.maximumBlockSize * factor, spec.numChannels });
+        }
+
+        if (activeBlendMode == BassBoostBlendMode::mixer)
+        {
+            // The mixer sizes its dry delay line when constructed, so it is
+            // built on the first prepare for the latency then, none without
+            // oversampling, and rebuilt only when oversampling needs more.
+            // Rebuilding restarts its mix ramp, as the first prepare does.
+            if (mixDryWet == nullptr || getLatencySamples() > mixerMaximumLatency)
+            {
+                mixerMaximumLatency = getLatencySamples();
+                mixDryWet = std::make_unique<dsp::DryWetMixer<SampleType>>(mixerMaximumLatency);
+            }
+
+            mixDryWet->prepare(spec);
+            mixDryWet->setWetLatency((SampleType) getLatencySamples());
+            mixDryWet->setMixingRule(dsp::DryWetMixingRule::linear);
+            mixDryWet->setWetMixProportion(wetProportion);
+            wetChunk.setSize(0, 0);
+        }
+        else
+        {
+            mixDryWet = nullptr;
+            wetChunk.setSize((int) spec.numChannels, (int) blendChunkSize);
+
+            dryVolume.reset(spec.sampleRate, 0.05);
+            wetVolume.reset(spec.sampleRate, 0.05);
+            dryVolume.setTargetValue(SampleType(1) - wetProportion);
+            wetVolume.setTargetValue(wetProportion);
+        }
+
+        processors.template get<preCompIndex>().setThreshold(SampleType(-120));
+
+        auto& boostLpf = processors.template get<boostLpfIndex>();
+        boostLpf.setMode(dsp::LadderFilterMode::LPF12);
+        boostLpf.setResonance(SampleType(0));
+    }
+
+    void reset()
+    {
+        preAmp.reset();
+        processors.reset();
+        postAmp.reset();
+        ladderOversampler.reset();
+
+        if (activeBlendMode == BassBoostBlendMode::mixer)
+        {
+            if (mixDryWet != nullptr)
+                mixDryWet->reset();
+        }
+        else
+        {
+            dryVolume.setCurrentAndTargetValue(dryVolume.getTargetValue());
+            wetVolume.setCurrentAndTargetValue(wetVolume.getTargetValue());
+        }
+    }
+
+    // Only the stages whose inputs are flagged in changes are updated.
+    void setParameters(const BassBoostParameters& parameters, int changes = BassBoostParameters::allChanged)
+    {
+        if (changes & BassBoostParameters::preGainChanged)
+            preAmp.setGainDecibels((SampleType) parameters.preGain);
+
+        auto& preComp = processors.template get<preCompIndex>();
+
+        if (changes & BassBoostParameters::speedChanged)
+        {
+            preComp.setAttack((SampleType) parameters.speed);
+            preComp.setRelease((SampleType) parameters.speed);
+        }
+
+        if (changes & BassBoostParameters::ratioChanged)
+            preComp.setRatio((SampleType) parameters.ratio);
+
+        auto& boostLpf = processors.template get<boostLpfIndex>();
+
+        if (changes & BassBoostParameters::boostFreqChanged)
+            boostLpf.setCutoffFrequencyHz((SampleType) parameters.boostFreq);
+
+        if (changes & BassBoostParameters::boostDriveChanged)
+            boostLpf.setDrive(Decibels::decibelsToGain((SampleType) parameters.boostDrive));
+
+        if (changes & (BassBoostParameters::amountChanged | BassBoostParameters::ratioChanged))
+            processors.template get<boostAmpIndex>().setGainLinear(parameters.getBoostGain<SampleType>());
+
+        if (changes & BassBoostParameters::postGainChanged)
+            postAmp.setGainDecibels(parameters.getPostGainDecibels<SampleType>());
+    }
+
+   #if DAMNBASSBOOST_PROFILE_STAGES
+    void setStageProfiler(StageProfiler* newProfiler) noexcept { stageProfiler = newProfiler; }
+   #endif
+
+    void process(const dsp::ProcessContextReplacing<SampleType>& context)
+    {
+        {
+            DAMNBASSBOOST_PROFILE_STAGE(stageProfiler, preAmp);
+            preAmp.process(context);
+        }
+
+        if (activeBlendMode == BassBoostBlendMode::mixer)
+        {
+            {
+                DAMNBASSBOOST_PROFILE_STAGE(stageProfiler, pushDrySamples);
+                mixDryWet->pushDrySamples(context.getInputBlock());
+            }
+
+            processChain(context);
+
+            DAMNBASSBOOST_PROFILE_STAGE(stageProfiler, mixWetSamples);
+            mixDryWet->mixWetSamples(context.getOutputBlock());
+        }
+        else
+        {
+            blendInPlace(context.getOutputBlock());
+        }
+
+        DAMNBASSBOOST_PROFILE_STAGE(stageProfiler, postAmp);
+        postAmp.process(context);
+    }
+
+private:
+    // What dsp::ProcessorChain::process does, one stage at a time so each can
+    // be profiled: the first stage takes the context as given, the others
+    // work in place on its output.
+    template <typename ProcessContext>
+    void processChain(const ProcessContext& context) noexcept
+    {
+        {
+            DAMNBASSBOOST_PROFILE_STAGE(stageProfiler, compressor);
+            processors.template get<preCompIndex>().process(context);
+        }
+
+        const dsp::ProcessContextReplacing<SampleType> replacing(context.getOutputBlock());
+
+        {
+            DAMNBASSBOOST_PROFILE_STAGE(stageProfiler, ladderFilter);
+            auto& boostLpf = processors.template get<boostLpfIndex>();
+
+            if (ladderOversampler.isActive())
+            {
+                auto oversampled = ladderOversampler.processSamplesUp(replacing.getOutputBlock());
+                boostLpf.process(dsp::ProcessContextReplacing<SampleType>(oversampled));
+                ladderOversampler.processSamplesDown(replacing.getOutputBlock());
+            }
+            else
+            {
+                boostLpf.process(replacing);
+            }
+        }
+
+        DAMNBASSBOOST_PROFILE_STAGE(stageProfiler, boostGain);
+        processors.template get<boostAmpIndex>().process(replacing);
+    }
+
+    // dsp::DryWetMixer's linear rule, output = wet * wetVolume + dry * dryVolume,
+    // one chunk at a time so the wet samples stay in cache until they are summed.
+    void blendInPlace(dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto numChannels = block.getNumChannels();
+        const auto numSamples = block.getNumSamples();
+
+        for (size_t start = 0; start < numSamples; start += blendChunkSize)
+        {
+            const auto length = jmin(blendChunkSize, numSamples - start);
+
+            auto dry = block.getSubBlock(start, length);
+            auto wet = dsp::AudioBlock<SampleType>(wetChunk).getSubsetChannelBlock(0, numChannels).getSubBlock(0, length);
+            const dsp::AudioBlock<const SampleType> dryInput(dry);
+            processChain(dsp::ProcessContextNonReplacing<SampleType>(dryInput, wet));
+
+            DAMNBASSBOOST_PROFILE_STAGE(stageProfiler, inPlaceBlend);
+
+            // The wet path has read the chunk; the dry sum uses it delayed as much as the wet path.
+            if (ladderOversampler.isActive())
+                ladderOversampler.delayDry(dry);
+
+            if (! dryVolume.isSmoothing() && ! wetVolume.isSmoothing())
+            {
+                const auto dryGain = dryVolume.getNextValue();
+                const auto wetGain = wetVolume.getNextValue();
+
+                for (size_t ch = 0; ch < numChannels; ++ch)
+                {
+                    auto* output = dry.getChannelPointer(ch);
+                    const auto* wetSamples = wet.getChannelPointer(ch);
+
+                    for (size_t i = 0; i < length; ++i)
+                        output[i] = wetSamples[i] * wetGain + output[i] * dryGain;
+                }
+
+                continue;
+            }
+
+            for (size_t i = 0; i < length; ++i)
+            {
+                const auto dryGain = dryVolume.getNextValue();
+                const auto wetGain = wetVolume.getNextValue();
+
+                for (size_t ch = 0; ch < numChannels; ++ch)
+                {
+                    auto* output = dry.getChannelPointer(ch);
+                    output[i] = wet.getChannelPointer(ch)[i] * wetGain + output[i] * dryGain;
+                }
+            }
+        }
+    }
+
+    static constexpr size_t blendChunkSize = 64;
+    static constexpr SampleType wetProportion = SampleType(0.5);
+
+    enum
+    {
+        preCompIndex,
+        boostLpfIndex,
+        boostAmpIndex,
+    };
+
+    dsp::Gain<SampleType> preAmp;
+
+    dsp::ProcessorChain<
+        dsp::Compressor<SampleType>,
+        dsp::LadderFilter<SampleType>,
+        dsp::Gain<SampleType>
+    > processors;
+
+    // Only in the mixer blend, sized for the wet latency; see prepare().
+    std::unique_ptr<dsp::DryWetMixer<SampleType>> mixDryWet;
+    int mixerMaximumLatency = 0;
+    BassBoostBlendMode blendMode = BassBoostBlendMode::mixer;
+    BassBoostBlendMode activeBlendMode = BassBoostBlendMode::mixer;
+    SmoothedValue<SampleType> dryVolume, wetVolume;
+    AudioBuffer<SampleType> wetChunk;
+
+    BassBoostOversampling oversampling = BassBoostOversampling::x1;
+    BassBoostOversampler<SampleType> ladderOversampler;
+
+    dsp::Gain<SampleType> postAmp;
+
+   #if DAMNBASSBOOST_PROFILE_STAGES
+    StageProfiler* stageProfiler = nullptr;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChainBassBoost)
+};
+
+//==============================================================================
+// The same signal path as ChainBassBoost computed in a single pass: every
+// sample frame goes through pre-gain, envelope detection, gain computation,
+// the ladder filter, the boost gain, the dry/wet sum and post-gain while it
+// is still in registers. It reproduces the arithmetic of dsp::Compressor,
+// dsp::LadderFilter (LPF12, no resonance), dsp::Gain and dsp::DryWetMixer,
+// including their smoothing, so both engines produce the same output.
+//
+// Up to two channels are processed one after the other. With more, as for
+// surround layouts, the channels are processed in SIMD lanes, and the values
+// every channel shares (smoothed coefficients, the linked detector) are
+// computed once per frame for all of them.
+//
+// Blocks of digital silence are skipped once the envelopes and the filter
+// state have decayed below audibility (see processSilence()).
+template <typename SampleType>
+class FusedBassBoost
+{
+public:
+   #if JUCE_USE_SIMD
+    using Register = dsp::SIMDRegister<SampleType>;
+    static constexpr size_t lanes = Register::SIMDNumElements;
+   #endif
+
+    FusedBassBoost()
+    {
+        // dsp::DryWetMixer starts at its default mix, fully wet, and ramps to
+        // the 50/50 mix over 50 ms after its first prepare; later prepares
+        // start settled. prepare() does the same.
+        dryVolume.setCurrentAndTargetValue(SampleType(0));
+        wetVolume.setCurrentAndTargetValue(SampleType(1));
+    }
+
+    // Takes effect on the next prepare().
+    void setOversampling(BassBoostOversampling newOversampling) { oversampling = newOversampling; }
+
+    // The delay added by oversampling the ladder, valid after prepare().
+    int getLatencySamples() const noexcept { return ladderOversampler.getLatencySamples(); }
+
+    // Takes effect on the next prepare().
+    void setDetector(BassBoostDetector newDetector) { detector = newDetector; }
+
+    void prepare(const dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        activeDetector = detector;
+
+        if (activeDetector == BassBoostDetector::envelope)
+        {
+            envelopeDetector.prepare(sampleRate, spec.numChannels, spec.maximumBlockSize);
+            envelopeDetector.setThreshold(threshold);
+            envelopeDetector.setLinked(linkDetector);
+        }
+
+        ladderOversampler.prepare(oversampling, spec.numChannels, spec.maximumBlockSize);
+        ladderRate = sampleRate * ladderOversampler.getFactor();
+
+        if (ladderOversampler.isActive())
+        {
+            const auto maxFrames = (int) jmax((uint32) 1, spec.maximumBlockSize);
+            drySamples.setSize((int) spec.numChannels, maxFrames);
+            wetSamples.setSize((int) spec.numChannels, maxFrames);
+            oversampledDryVolumes.resize((size_t) maxFrames);
+            oversampledWetVolumes.resize((size_t) maxFrames);
+        }
+        else
+        {
+            drySamples.setSize(0, 0);
+            wetSamples.setSize(0, 0);
+        }
+
+        envelopes.resize(spec.numChannels);
+        ladderStates.resize(spec.numChannels);
+        inputChannels.resize(spec.numChannels);
+        outputChannels.resize(spec.numChannels);
+
+       #if JUCE_USE_SIMD
+        useChannelGroups = spec.numChannels > 2;
+
+        if (useChannelGroups)
+        {
+            channelGroups.resize((spec.numChannels + lanes - 1) / lanes);
+            const auto maxFrames = (size_t) jmax((uint32) 1, spec.maximumBlockSize);
+            groupSamples.resize(maxFrames);
+            frameCutoffTransforms.resize(maxFrames);
+            frameDryVolumes.resize(maxFrames);
+            frameWetVolumes.resize(maxFrames);
+            frameCompressorGains.resize(maxFrames);
+            groupCompressorGains.resize(activeDetector == BassBoostDetector::envelope ? maxFrames : 0);
+        }
+       #endif
+
+        cutoffTransform.reset(ladderRate, SampleType(0.05));
+        updateCutoffTransform();
+
+        updateBallistics();
+
+        // SmoothedValue::reset() settles each volume at its previous target, as
+        // DryWetMixer::reset() does, so only the first prepare ramps.
+        dryVolume.reset(sampleRate, 0.05);
+        wetVolume.reset(sampleRate, 0.05);
+        dryVolume.setTargetValue(SampleType(1) - wetProportion);
+        wetVolume.setTargetValue(wetProportion);
+
+        clearState();
+        cutoffTransform.setCurrentAndTargetValue(cutoffTransform.getTargetValue());
+    }
+
+    void reset()
+    {
+        clearState();
+        skipSmoothing();
+    }
+
+    // Continues from where other is: the detector envelopes, ladder states,
+    // dry delay and cutoff and dry/wet ramps of an engine prepared with the
+    // same spec and options. Parameters are not copied; set them afterwards.
+    // Only the oversampling filters restart from silence. Does not allocate.
+    void copyStateFrom(const FusedBassBoost& other) noexcept
+    {
+        jassert(envelopes.size() == other.envelopes.size());
+
+        std::copy(other.envelopes.begin(), other.envelopes.end(), envelopes.begin());
+        linkedEnvelope = other.linkedEnvelope;
+        linkDetector = other.linkDetector;
+        envelopeDetector.copyStateFrom(other.envelopeDetector);
+        ladderOversampler.copyStateFrom(other.ladderOversampler);
+        std::copy(other.ladderStates.begin(), other.ladderStates.end(), ladderStates.begin());
+
+       #if JUCE_USE_SIMD
+        std::copy(other.channelGroups.begin(), other.channelGroups.end(), channelGroups.begin());
+       #endif
+
+        cutoffTransform = other.cutoffTransform;
+        dryVolume = other.dryVolume;
+        wetVolume = other.wetVolume;
+        stateCleared = other.stateCleared;
+    }
+
+    // Jumps the cutoff and dry/wet ramps to their targets.
+    void skipSmoothing() noexcept
+    {
+        cutoffTransform.setCurrentAndTargetValue(cutoffTransform.getTargetValue());
+        dryVolume.setCurrentAndTargetValue(dryVolume.getTargetValue());
+        wetVolume.setCurrentAndTargetValue(wetVolume.getTargetValue());
+    }
+
+    // Only the coefficients whose inputs are flagged in changes are recomputed.
+    void setParameters(const BassBoostParameters& parameters, int changes = BassBoostParameters::allChanged)
+    {
+        if (changes & BassBoostParameters::preGainChanged)
+            preGain = Decibels::decibelsToGain((SampleType) parameters.preGain);
+
+        if (changes & BassBoostParameters::speedChanged)
+        {
+            speedMs = (SampleType) parameters.speed;
+            updateBallistics();
+        }
+
+        if (changes & BassBoostParameters::ratioChanged)
+            ratioInverse = SampleType(1) / (SampleType) parameters.ratio;
+
+        if (changes & BassBoostParameters::boostFreqChanged)
+        {
+            cutoffFreqHz = (SampleType) parameters.boostFreq;
+            updateCutoffTransform();
+        }
+
+        if (changes & BassBoostParameters::boostDriveChanged)
+            setDrive(Decibels::decibelsToGain((SampleType) parameters.boostDrive));
+
+        if (changes & (BassBoostParameters::amountChanged | BassBoostParameters::ratioChanged))
+            boostGain = parameters.getBoostGain<SampleType>();
+
+        if (changes & BassBoostParameters::postGainChanged)
+            postGain = Decibels::decibelsToGain(parameters.getPostGainDecibels<SampleType>());
+
+        if (changes & BassBoostParameters::linkDetectorChanged)
+            setLinkDetector(parameters.linkDetector);
+    }
+
+    // The loudest detector envelope, after pre-gain.
+    SampleType getDetectorEnvelope() const noexcept
+    {
+        auto envelope = jmax(linkedEnvelope, envelopeDetector.getEnvelope());
+
+        for (auto e : envelopes)
+            envelope = jmax(envelope, e);
+
+       #if JUCE_USE_SIMD
+        for (auto& group : channelGroups)
+            for (size_t l = 0; l < lanes; ++l)
+                envelope = jmax(envelope, group.envelope.get(l));
+       #endif
+
+        return envelope;
+    }
+
+    // Gain of the wet path relative to the dry path for a detector envelope.
+    SampleType getBoostForEnvelope(SampleType envelope) const noexcept
+    {
+        const auto compressorGain = envelope < threshold ? SampleType(1)
+                                                         : power(envelope * thresholdInverse, ratioInverse - SampleType(1));
+
+        return compressorGain * ladderOutputGain * boostGain;
+    }
+
+    // Optional tables for the sample rate passed to prepare(); nullptr computes every coefficient.
+    void setCoefficientTables(const BassBoostCoefficientTables<SampleType>* newTables) noexcept
+    {
+        coefficientTables = newTables;
+    }
+
+    void setQuality(BassBoostQuality newQuality) noexcept { quality = newQuality; }
+    BassBoostQuality getQuality() const noexcept { return quality; }
+
+    // Picks the kernel variant; automatic takes the best one the CPU runs. The
+    // baseline runs until this is called.
+    void setInstructionSet(BassBoostInstructionSet requested)
+    {
+        instructionSet = BassBoostDispatch::resolve(requested);
+
+        switch (instructionSet)
+        {
+           #if DAMNBASSBOOST_ISA_DISPATCH
+            case BassBoostInstructionSet::avx2:   kernel = &FusedBassBoost::processAvx2; break;
+            case BassBoostInstructionSet::avx512: kernel = &FusedBassBoost::processAvx512; break;
+           #endif
+            default:                              kernel = &FusedBassBoost::processBaseline; break;
+        }
+    }
+
+    // The variant in use, never automatic.
+    BassBoostInstructionSet getInstructionSet() const noexcept { return instructionSet; }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numChannels = outputBlock.getNumChannels();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert(inputBlock.getNumChannels() == numChannels);
+        jassert(inputBlock.getNumSamples() == numSamples);
+        jassert(numChannels <= envelopes.size());
+
+        if (context.isBypassed)
+        {
+            outputBlock.copyFrom(inputBlock);
+            return;
+        }
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            inputChannels[ch] = inputBlock.getChannelPointer(ch);
+            outputChannels[ch] = outputBlock.getChannelPointer(ch);
+        }
+
+        if (processSilence(numChannels, numSamples))
+            return;
+
+        stateCleared = false;
+
+        if (activeDetector == BassBoostDetector::envelope)
+            envelopeDetector.process(inputChannels.data(), numChannels, numSamples, preGain, ratioInverse - SampleType(1));
+
+        if (ladderOversampler.isActive())
+            processOversampled(numChannels, numSamples);
+        else
+            (this->*kernel)(numChannels, numSamples);
+    }
+
+private:
+    //==============================================================================
+    // The per-sample work of process(), compiled once per instruction set and
+    // detector. Everything it calls is force-inlined so it is built for the
+    // same set. With the envelope detector the gains come from its rows.
+    template <bool envelopeDetection>
+    JUCE_FORCEINLINE void processKernel(size_t numChannels, size_t numSamples) noexcept
+    {
+       #if JUCE_USE_SIMD
+        if (useChannelGroups)
+        {
+            processChannelGroups<envelopeDetection>(numChannels, numSamples);
+            return;
+        }
+       #endif
+
+        const auto* const* detectorGains = envelopeDetector.getGains();
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto a1 = cutoffTransform.getNextValue();
+            const auto g = a1 * SampleType(-1) + SampleType(1);
+            const auto b0 = g * SampleType(0.76923076923);
+            const auto b1 = g * SampleType(0.23076923076);
+
+            const auto wetScale = wetVolume.getNextValue();
+            const auto dryScale = dryVolume.getNextValue();
+
+            const auto linkedGain = linkDetector && ! envelopeDetection ? detectLinked(i, numChannels) : SampleType(1);
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                const auto dry = inputChannels[ch][i] * preGain;
+
+                const auto compressorGain = envelopeDetection ? detectorGains[ch][i]
+                                          : linkDetector ? linkedGain : detect(envelopes[ch], std::abs(dry));
+
+                const auto c = processLadder(ladderStates[ch], compressorGain * dry, a1, b0, b1);
+                const auto wet = c * ladderOutputGain * boostGain;
+
+                outputChannels[ch][i] = (wet * wetScale + dry * dryScale) * postGain;
+            }
+        }
+    }
+
+    // dsp::LadderFilter in LPF12 mode; returns its output.
+    JUCE_FORCEINLINE SampleType processLadder(std::array<SampleType, 5>& s, SampleType input,
+                                              SampleType a1, SampleType b0, SampleType b1) const noexcept
+    {
+        const auto dx = driveGain * saturation(drive * input);
+        const auto a = dx + scaledResonance * SampleType(-4) * (driveGain2 * saturation(drive2 * s[4]) - dx * SampleType(0.5));
+        const auto b = b1 * s[0] + a1 * s[1] + b0 * a;
+        const auto c = b1 * s[1] + a1 * s[2] + b0 * b;
+        const auto d = b1 * s[2] + a1 * s[3] + b0 * c;
+        const auto e = b1 * s[3] + a1 * s[4] + b0 * d;
+
+        s[0] = a;
+        s[1] = b;
+        s[2] = c;
+        s[3] = d;
+        s[4] = e;
+
+        return c;
+    }
+
+    // With the ladder oversampled the single pass is split in three: the
+    // detector and the ladder input at the host rate, the ladder at the
+    // oversampled rate, and the dry/wet sum with the dry path delayed by the
+    // filters' latency. Any channel count runs through here one channel at a
+    // time, with the baseline instruction set.
+    void processOversampled(size_t numChannels, size_t numSamples) noexcept
+    {
+        const auto maxFrames = (size_t) drySamples.getNumSamples();
+        const auto factor = (size_t) ladderOversampler.getFactor();
+        const auto envelopeDetection = activeDetector == BassBoostDetector::envelope;
+        const auto* const* detectorGains = envelopeDetector.getGains();
+
+        for (size_t offset = 0; offset < numSamples; offset += maxFrames)
+        {
+            const auto numFrames = jmin(maxFrames, numSamples - offset);
+
+            for (size_t i = 0; i < numFrames; ++i)
+            {
+                oversampledWetVolumes[i] = wetVolume.getNextValue();
+                oversampledDryVolumes[i] = dryVolume.getNextValue();
+
+                const auto linkedGain = linkDetector && ! envelopeDetection ? detectLinked(offset + i, numChannels) : SampleType(1);
+
+                for (size_t ch = 0; ch < numChannels; ++ch)
+                {
+                    const auto dry = inputChannels[ch][offset + i] * preGain;
+                    const auto compressorGain = envelopeDetection ? detectorGains[ch][offset + i]
+                                              : linkDetector ? linkedGain : detect(envelopes[ch], std::abs(dry));
+
+                    drySamples.setSample((int) ch, (int) i, dry);
+                    wetSamples.setSample((int) ch, (int) i, compressorGain * dry);
+                }
+            }
+
+            auto wetBlock = dsp::AudioBlock<SampleType>(wetSamples).getSubsetChannelBlock(0, numChannels).getSubBlock(0, numFrames);
+            auto oversampled = ladderOversampler.processSamplesUp(wetBlock);
+
+            for (size_t i = 0; i < numFrames * factor; ++i)
+            {
+                const auto a1 = cutoffTransform.getNextValue();
+                const auto g = a1 * SampleType(-1) + SampleType(1);
+                const auto b0 = g * SampleType(0.76923076923);
+                const auto b1 = g * SampleType(0.23076923076);
+
+                for (size_t ch = 0; ch < numChannels; ++ch)
+                {
+                    auto* samples = oversampled.getChannelPointer(ch);
+                    samples[i] = processLadder(ladderStates[ch], samples[i], a1, b0, b1);
+                }
+            }
+
+            ladderOversampler.processSamplesDown(wetBlock);
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                const auto* wet = wetSamples.getReadPointer((int) ch);
+                const auto* dry = drySamples.getReadPointer((int) ch);
+                auto* output = outputChannels[ch] + offset;
+
+                for (size_t i = 0; i < numFrames; ++i)
+                {
+                    const auto delayedDry = ladderOversampler.delayDry(ch, dry[i]);
+                    output[i] = (wet[i] * ladderOutputGain * boostGain * oversampledWetVolumes[i]
+                                 + delayedDry * oversampledDryVolumes[i]) * postGain;
+                }
+            }
+        }
+    }
+
+    using Kernel = void (FusedBassBoost::*)(size_t, size_t) noexcept;
+
+    DAMNBASSBOOST_KERNEL_BASELINE void processBaseline(size_t numChannels, size_t numSamples) noexcept
+    {
+        activeDetector == BassBoostDetector::envelope ? processKernel<true>(numChannels, numSamples)
+                                                      : processKernel<false>(numChannels, numSamples);
+    }
+
+   #if DAMNBASSBOOST_ISA_DISPATCH
+    DAMNBASSBOOST_KERNEL_TARGET("avx2") void processAvx2(size_t numChannels, size_t numSamples) noexcept
+    {
+        activeDetector == BassBoostDetector::envelope ? processKernel<true>(numChannels, numSamples)
+                                                      : processKernel<false>(numChannels, numSamples);
+    }
+
+    DAMNBASSBOOST_KERNEL_TARGET("avx512f") void processAvx512(size_t numChannels, size_t numSamples) noexcept
+    {
+        activeDetector == BassBoostDetector::envelope ? processKernel<true>(numChannels, numSamples)
+                                                      : processKernel<false>(numChannels, numSamples);
+    }
+   #endif
+
+   #if JUCE_USE_SIMD
+    // Per-lane state when there are more than two channels
+    struct ChannelGroup
+    {
+        Register envelope;
+        std::array<Register, 5> state;
+    };
+   #endif
+
+    //==============================================================================
+    void clearState() noexcept
+    {
+        std::fill(envelopes.begin(), envelopes.end(), SampleType(0));
+        linkedEnvelope = SampleType(0);
+        envelopeDetector.reset();
+        ladderOversampler.reset();
+
+        for (auto& state : ladderStates)
+            state.fill(SampleType(0));
+
+       #if JUCE_USE_SIMD
+        for (auto& group : channelGroups)
+        {
+            group.envelope = Register::expand(SampleType(0));
+            group.state.fill(Register::expand(SampleType(0)));
+        }
+       #endif
+
+        stateCleared = true;
+    }
+
+    // With silent input, an envelope below the compressor threshold and a
+    // ladder state whose output, after the wet path's gain, is below half the
+    // last bit of a 24-bit signal, the tail would round to silence there (see
+    // isStateDecayed()). The state is then cleared and the block
+    // zeroed instead of processed; while the state stays cleared, silent
+    // blocks cost one scan of the input. Blocks with smoothing in progress
+    // are always processed, so ramps stay sample accurate.
+    bool processSilence(size_t numChannels, size_t numSamples) noexcept
+    {
+        if (cutoffTransform.isSmoothing() || dryVolume.isSmoothing() || wetVolume.isSmoothing())
+            return false;
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            for (size_t i = 0; i < numSamples; ++i)
+                if (inputChannels[ch][i] != SampleType(0))
+                    return false;
+
+        if (! stateCleared)
+        {
+            if (! isStateDecayed())
+                return false;
+
+            clearState();
+        }
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            std::fill(outputChannels[ch], outputChannels[ch] + numSamples, SampleType(0));
+
+        return true;
+    }
+
+    // The ladder output reaches the output through the boost, the wet mix and
+    // the post gain, together up to about 10^5 at extreme settings, so the
+    // state is judged by the level it would be heard at.
+    bool isStateDecayed() const noexcept
+    {
+        const auto quietLevel = SampleType(1) / SampleType(1 << 24);
+        const auto wetGain = ladderOutputGain * boostGain * wetVolume.getTargetValue() * postGain;
+
+        auto level = SampleType(0);
+
+        for (auto& state : ladderStates)
+            for (auto x : state)
+                level = jmax(level, std::abs(x));
+
+       #if JUCE_USE_SIMD
+        for (auto& group : channelGroups)
+            for (size_t l = 0; l < lanes; ++l)
+                for (auto& x : group.state)
+                    level = jmax(level, std::abs(x.get(l)));
+       #endif
+
+        return getDetectorEnvelope() < threshold && level * wetGain < quietLevel && ladderOversampler.isDryDelaySilent();
+    }
+
+    // Peak ballistics and gain computer of dsp::Compressor
+    JUCE_FORCEINLINE SampleType detect(SampleType& envelope, SampleType rectified) const noexcept
+    {
+        const auto cte = rectified > envelope ? attackCte : releaseCte;
+        envelope = rectified + cte * (envelope - rectified);
+
+        return envelope < threshold ? SampleType(1)
+                                    : power(envelope * thresholdInverse, ratioInverse - SampleType(1));
+    }
+
+    // The linked detector follows the loudest channel of the frame.
+    JUCE_FORCEINLINE SampleType detectLinked(size_t index, size_t numChannels) noexcept
+    {
+        auto peak = SampleType(0);
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            peak = jmax(peak, std::abs(inputChannels[ch][index] * preGain));
+
+        return detect(linkedEnvelope, peak);
+    }
+
+    // Hands the detector state over, so the gain does not jump when linking is toggled.
+    void setLinkDetector(bool shouldLink) noexcept
+    {
+        if (shouldLink == linkDetector)
+            return;
+
+        linkDetector = shouldLink;
+        envelopeDetector.setLinked(linkDetector);
+
+        if (linkDetector)
+        {
+            linkedEnvelope = SampleType(0);
+
+            for (auto envelope : envelopes)
+                linkedEnvelope = jmax(linkedEnvelope, envelope);
+
+           #if JUCE_USE_SIMD
+            for (auto& group : channelGroups)
+                for (size_t l = 0; l < lanes; ++l)
+                    linkedEnvelope = jmax(linkedEnvelope, group.envelope.get(l));
+           #endif
+        }
+        else
+        {
+            std::fill(envelopes.begin(), envelopes.end(), linkedEnvelope);
+
+           #if JUCE_USE_SIMD
+            for (auto& group : channelGroups)
+                group.envelope = Register::expand(linkedEnvelope);
+           #endif
+        }
+    }
+
+   #if JUCE_USE_SIMD
+    // Computes the per-frame values once, then runs each group of lanes over
+    // the block with the same arithmetic as the scalar loop.
+    template <bool envelopeDetection>
+    JUCE_FORCEINLINE void processChannelGroups(size_t numChannels, size_t numSamples) noexcept
+    {
+        const auto maxFrames = groupSamples.size();
+
+        for (size_t offset = 0; offset < numSamples; offset += maxFrames)
+        {
+            const auto numFrames = jmin(maxFrames, numSamples - offset);
+
+            for (size_t i = 0; i < numFrames; ++i)
+            {
+                frameCutoffTransforms[i] = cutoffTransform.getNextValue();
+                frameWetVolumes[i] = wetVolume.getNextValue();
+                frameDryVolumes[i] = dryVolume.getNextValue();
+
+                if (linkDetector && ! envelopeDetection)
+                    frameCompressorGains[i] = detectLinked(offset + i, numChannels);
+            }
+
+            for (size_t groupIndex = 0; groupIndex < channelGroups.size(); ++groupIndex)
+            {
+                const auto firstChannel = groupIndex * lanes;
+
+                if (firstChannel >= numChannels)
+                    break;
+
+                const auto numActive = jmin(lanes, numChannels - firstChannel);
+
+                BassBoostLanes::load(inputChannels.data() + firstChannel, numActive, offset, numFrames, groupSamples.data());
+
+                if (envelopeDetection)
+                    BassBoostLanes::load(envelopeDetector.getGains() + firstChannel, numActive, offset, numFrames, groupCompressorGains.data());
+
+                processGroup<envelopeDetection>(channelGroups[groupIndex], numFrames);
+                BassBoostLanes::store(groupSamples.data(), outputChannels.data() + firstChannel, numActive, offset, numFrames);
+            }
+        }
+    }
+
+    template <bool envelopeDetection>
+    JUCE_FORCEINLINE void processGroup(ChannelGroup& group, size_t numFrames) noexcept
+    {
+        const auto exponent = Register::expand(ratioInverse - SampleType(1));
+        const auto resonance = scaledResonance * SampleType(-4);
+        auto& s = group.state;
+
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            const auto a1 = frameCutoffTransforms[i];
+            const auto g = a1 * SampleType(-1) + SampleType(1);
+            const auto b0 = Register::expand(g * SampleType(0.76923076923));
+            const auto b1 = Register::expand(g * SampleType(0.23076923076));
+            const auto a1s = Register::expand(a1);
+
+            const auto dry = groupSamples[i] * preGain;
+
+            Register compressorGain;
+
+            if (envelopeDetection)
+            {
+                compressorGain = groupCompressorGains[i];
+            }
+            else if (linkDetector)
+            {
+                compressorGain = Register::expand(frameCompressorGains[i]);
+            }
+            else
+            {
+                const auto rectified = Register::abs(dry);
+                group.envelope = rectified + (group.envelope - rectified) * attackCte;
+                compressorGain = BassBoostLanes::getCompressorGain(group.envelope, threshold, thresholdInverse, exponent, quality);
+            }
+
+            const auto dx = BassBoostLanes::saturate((compressorGain * dry) * drive, quality) * driveGain;
+            const auto a = dx + (BassBoostLanes::saturate(s[4] * drive2, quality) * driveGain2 - dx * SampleType(0.5)) * resonance;
+            const auto b = b1 * s[0] + a1s * s[1] + b0 * a;
+            const auto c = b1 * s[1] + a1s * s[2] + b0 * b;
+            const auto d = b1 * s[2] + a1s * s[3] + b0 * c;
+            const auto e = b1 * s[3] + a1s * s[4] + b0 * d;
+
+            s[0] = a;
+            s[1] = b;
+            s[2] = c;
+            s[3] = d;
+            s[4] = e;
+
+            const auto wet = c * ladderOutputGain * boostGain;
+
+            groupSamples[i] = (wet * frameWetVolumes[i] + dry * frameDryVolumes[i]) * postGain;
+        }
+    }
+   #endif
+
+    JUCE_FORCEINLINE SampleType saturation(SampleType x) const noexcept
+    {
+        return quality == BassBoostQuality::reference ? saturationTable(x)
+                                                      : BassBoostApproximations::tanh(x, quality);
+    }
+
+    JUCE_FORCEINLINE SampleType power(SampleType x, SampleType y) const noexcept
+    {
+        return quality == BassBoostQuality::reference ? std::pow(x, y)
+                                                      : BassBoostApproximations::pow(x, y, quality);
+    }
+
+    void updateBallistics() noexcept
+    {
+        if (coefficientTables == nullptr || ! coefficientTables->lookupBallisticsCte(speedMs, attackCte))
+            attackCte = BassBoostCoefficients::getBallisticsCte(speedMs, sampleRate);
+
+        releaseCte = attackCte;
+        envelopeDetector.setSpeed(speedMs);
+    }
+
+    void updateCutoffTransform() noexcept
+    {
+        SampleType transform;
+
+        // The tables are for the host rate, so an oversampled ladder computes its own.
+        if (coefficientTables == nullptr || ladderOversampler.isActive()
+            || ! coefficientTables->lookupCutoffTransform(cutoffFreqHz, transform))
+            transform = BassBoostCoefficients::getCutoffTransform(cutoffFreqHz, ladderRate);
+
+        cutoffTransform.setTargetValue(transform);
+    }
+
+    void setDrive(SampleType newDrive) noexcept
+    {
+        drive = newDrive;
+        driveGain = std::pow(drive, SampleType(-2.642)) * SampleType(0.6103) + SampleType(0.3903);
+        drive2 = drive * SampleType(0.04) + SampleType(0.96);
+        driveGain2 = std::pow(drive2, SampleType(-2.642)) * SampleType(0.6103) + SampleType(0.3903);
+    }
+
+    //==============================================================================
+    const dsp::LookupTableTransform<SampleType>& saturationTable = BassBoostCoefficients::getSaturationTable<SampleType>();
+    const BassBoostCoefficientTables<SampleType>* coefficientTables = nullptr;
+    BassBoostQuality quality = BassBoostQuality::reference;
+    BassBoostInstructionSet instructionSet = BassBoostInstructionSet::baseline;
+    Kernel kernel = &FusedBassBoost::processBaseline;
+
+    double sampleRate = 44100.0;
+
+    SampleType preGain = SampleType(1);
+
+    // Compressor with its threshold pinned at -120 dB
+    const SampleType threshold = Decibels::decibelsToGain(SampleType(-120), SampleType(-200));
+    const SampleType thresholdInverse = SampleType(1) / threshold;
+    SampleType ratioInverse = SampleType(1);
+    SampleType speedMs = SampleType(100);
+    SampleType attackCte = SampleType(0), releaseCte = SampleType(0);
+    std::vector<SampleType> envelopes;
+    bool linkDetector = false;
+    SampleType linkedEnvelope = SampleType(0);
+
+    BassBoostDetector detector = BassBoostDetector::compressor, activeDetector = BassBoostDetector::compressor;
+    BassBoostEnvelopeDetector<SampleType> envelopeDetector;
+
+    // Ladder filter
+    static constexpr SampleType ladderOutputGain = SampleType(1.2);
+    static constexpr SampleType scaledResonance = SampleType(0.1);
+    SampleType cutoffFreqHz = SampleType(200);
+    SmoothedValue<SampleType> cutoffTransform;
+    SampleType drive = SampleType(1), driveGain = SampleType(1), drive2 = SampleType(1), driveGain2 = SampleType(1);
+    std::vector<std::array<SampleType, 5>> ladderStates;
+
+    BassBoostOversampling oversampling = BassBoostOversampling::x1;
+    BassBoostOversampler<SampleType> ladderOversampler;
+    double ladderRate = 44100.0;
+    AudioBuffer<SampleType> drySamples, wetSamples;
+    std::vector<SampleType> oversampledDryVolumes, oversampledWetVolumes;
+
+    SampleType boostGain = SampleType(1);
+
+    // Dry/wet mix
+    static constexpr SampleType wetProportion = SampleType(0.5);
+    SmoothedValue<SampleType> dryVolume, wetVolume;
+
+    SampleType postGain = SampleType(1);
+
+    std::vector<const SampleType*> inputChannels;
+    std::vector<SampleType*> outputChannels;
+
+    bool stateCleared = true;
+
+   #if JUCE_USE_SIMD
+    bool useChannelGroups = false;
+    std::vector<ChannelGroup> channelGroups;
+    std::vector<Register> groupSamples;
+    std::vector<SampleType> frameCutoffTransforms, frameDryVolumes, frameWetVolumes, frameCompressorGains;
+    std::vector<Register> groupCompressorGains;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FusedBassBoost)
+};
@@ -4,14 +4,82 @@
 
 using namespace juce;
 
-class CustomLookAndFeel : public LookAndFeel_V4
+//==============================================================================
+// Counts paint calls and the time spent in them, per area. It lives in the
+// shared look and feel, so the totals cover every open editor until reset()
+// or until the last one closes. Message thread only; the cost is two tick
+// reads per paint.
+class PaintProfiler
 {
 public:
-    CustomLookAndFeel() {
-        LookAndFeel::setDefaultLookAndFeel(this);
+    enum Area
+    {
+        editor,
+        knobs,
+        meters,
+        numAreas,
+    };
+
+    struct ScopedPaint
+    {
+        ScopedPaint(PaintProfiler& p, Area a) : profiler(p), area(a), start(Time::getHighResolutionTicks()) {}
+        ~ScopedPaint() { profiler.add(area, Time::getHighResolutionTicks() - start); }
+
+        PaintProfiler& profiler;
+        Area area;
+        int64 start;
+    };
+
+    int64 getNumPaints(Area area) const noexcept { return counts[(size_t) area]; }
+    double getSeconds(Area area) const noexcept { return Time::highResolutionTicksToSeconds(ticks[(size_t) area]); }
+
+    String getSummary() const
+    {
+        static const char* const names[] = { "editor", "knobs", "meters" };
+        String summary;
+
+        for (int area = 0; area < numAreas; ++area)
+        {
+            auto numPaints = getNumPaints((Area) area);
+            auto seconds = getSeconds((Area) area);
+
+            summary << names[area] << ": " << numPaints << " paints, " << String(seconds * 1000.0, 2) << " ms"
+                    << (numPaints > 0 ? ", " + String(seconds * 1.0e6 / (double) numPaints, 1) + " us each" : String()) << newLine;
+        }
+
+        return summary;
     }
+
+    void reset() noexcept
+    {
+        ticks.fill(0);
+        counts.fill(0);
+    }
+
+private:
+    void add(Area area, int64 elapsed) noexcept
+    {
+        ticks[(size_t) area] += elapsed;
+        ++counts[(size_t) area];
+    }
+
+    std::array<int64, numAreas> ticks {};
+    std::array<int64, numAreas> counts {};
+};
+
+//==============================================================================
+// Shared by every open editor through a SharedResourcePointer, and set on
+// each editor rather than installed as the global default look and feel.
+// Everything an editor draws from is shared here, built on first use: the
+// typeface (once per process), the logo (parsed once, rendered once per size
+// and display scale) and the knob backgrounds (once per size and colour).
+class CustomLookAndFeel : public LookAndFeel_V4
+{
+public:
+    CustomLookAndFeel() {}
     ~CustomLookAndFeel() {}
 
+    // One typeface for the whole process
     static const Font getCustomFont()
     {
         static auto typeface = Typeface::createSystemTypefaceFor(BinaryData::RobotoRegular_ttf, BinaryData::RobotoRegular_ttfSize);
@@ -23,37 +91,54 @@ public:
         return getCustomFont().getTypefacePtr();
     }
 
+    // The logo fitted into a width x height area; editors draw this image
+    // instead of owning a copy of the Drawable and a buffered image of their own.
+    const Image& getLogoImage(int width, int height, float scale)
+    {
+        auto& image = logoImages[std::make_tuple(width, height, scale)];
+
+        if (image.isNull())
+        {
+            if (logo == nullptr)
+                logo = Drawable::createFromImageData(BinaryData::logo_svg, BinaryData::logo_svgSize);
+
+            image = Image(Image::ARGB, jmax(1, roundToInt((float) width * scale)), jmax(1, roundToInt((float) height * scale)), true);
+
+            Graphics g(image);
+            g.addTransform(AffineTransform::scale(scale));
+            logo->drawWithin(g, Rectangle<int>(0, 0, width, height).toFloat(), RectanglePlacement::centred, 1.0f);
+        }
+
+        return image;
+    }
+
     void drawRotarySlider(Graphics& g, int x, int y, int width, int height,
         float sliderPos, float rotaryStartAngle, float rotaryEndAngle,
-        Slider&) override
+        Slider& slider) override
     {
+        const PaintProfiler::ScopedPaint scopedPaint(paintProfiler, PaintProfiler::knobs);
+
+        // Opaque sliders cover the editor background themselves, so a moving
+        // knob does not make the editor repaint behind it.
+        if (slider.isOpaque())
+            g.fillAll(colourPalette[grey]);
+
+        auto area = Rectangle<int>(x, y, width, height);
+        auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        g.drawImage(getKnobBackground(width, height, rotaryStartAngle, rotaryEndAngle, scale), area.toFloat());
+
         auto toAngle = rotaryStartAngle + sliderPos * (rotaryEndAngle - rotaryStartAngle);
-        auto bounds = Rectangle<int>(x, y, width, height).toFloat().reduced(10);
+        auto bounds = area.toFloat().reduced(10);
         auto radius = jmin(bounds.getWidth(), bounds.getHeight()) / 2.0f;
         auto lineW = jmin(8.0f, radius * 0.5f);
         auto knobRadius = radius - lineW * 2;
         auto arcRadius = radius - lineW * 0.5f;
 
-        auto outlineColour = colourPalette[black];
         auto valueFillColour = colourPalette[green];
-        auto knobFillColour = colourPalette[white];
         auto thumbColour = colourPalette[black];
 
         //bool sliderPolarity = (slider.getRange().getStart() / slider.getRange().getEnd()) == -1.0;
 
-        Path backgroundArc;
-        backgroundArc.addCentredArc(
-            bounds.getCentreX(),
-            bounds.getCentreY(),
-            arcRadius,
-            arcRadius,
-            0.0f,
-            rotaryStartAngle,
-            rotaryEndAngle,
-            true);
-        g.setColour(outlineColour);
-        g.strokePath(backgroundArc, PathStrokeType(lineW, PathStrokeType::curved, PathStrokeType::butt));
-
         Path valueArc;
         valueArc.addCentredArc(
             bounds.getCentreX(),
@@ -67,13 +152,6 @@ public:
         g.setColour(valueFillColour);
         g.strokePath(valueArc, PathStrokeType(lineW, PathStrokeType::curved, PathStrokeType::butt));
 
-        g.setColour(knobFillColour);
-        g.fillEllipse(
-            bounds.getCentreX() - knobRadius,
-            bounds.getCentreY() - knobRadius,
-            knobRadius * 2,
-            knobRadius * 2);
-
         auto pointerDistance = knobRadius * 0.8f;
         auto pointerLength = knobRadius * 0.4f;
         Path pointer;
@@ -103,6 +181,8 @@ public:
         g.drawFittedText(label.getText(), label.getLocalBounds(), label.getJustificationType(), 1);
     }
     
+    PaintProfiler paintProfiler;
+
     enum colourIdx
     {
         grey,
@@ -121,5 +201,53 @@ public:
 private:
     //54626f,36454f,00cc99,f0f8ff,91a3b0
 
+    // The outline arc and the knob body do not move with the value. They are
+    // rendered once per knob size and display scale and drawn as an image.
+    const Image& getKnobBackground(int width, int height, float rotaryStartAngle, float rotaryEndAngle, float scale)
+    {
+        auto& image = knobBackgrounds[std::make_tuple(width, height, rotaryStartAngle, rotaryEndAngle, scale)];
+
+        if (image.isNull())
+        {
+            image = Image(Image::ARGB, jmax(1, roundToInt((float) width * scale)), jmax(1, roundToInt((float) height * scale)), true);
+
+            Graphics g(image);
+            g.addTransform(AffineTransform::scale(scale));
+
+            auto bounds = Rectangle<int>(0, 0, width, height).toFloat().reduced(10);
+            auto radius = jmin(bounds.getWidth(), bounds.getHeight()) / 2.0f;
+            auto lineW = jmin(8.0f, radius * 0.5f);
+            auto knobRadius = radius - lineW * 2;
+            auto arcRadius = radius - lineW * 0.5f;
+
+            Path backgroundArc;
+            backgroundArc.addCentredArc(
+                bounds.getCentreX(),
+                bounds.getCentreY(),
+                arcRadius,
+                arcRadius,
+                0.0f,
+                rotaryStartAngle,
+                rotaryEndAngle,
+                true);
+            g.setColour(colourPalette[black]);
+            g.strokePath(backgroundArc, PathStrokeType(lineW, PathStrokeType::curved, PathStrokeType::butt));
+
+            g.setColour(colourPalette[white]);
+            g.fillEllipse(
+                bounds.getCentreX() - knobRadius,
+                bounds.getCentreY() - knobRadius,
+                knobRadius * 2,
+                knobRadius * 2);
+        }
+
+        return image;
+    }
+
+    // Shared by all editors, see the class comment
+    std::map<std::tuple<int, int, float, float, float>, Image> knobBackgrounds;
+    std::unique_ptr<Drawable> logo;
+    std::map<std::tuple<int, int, float>, Image> logoImages;
+
     float fontSize = 18.0f;
 };
\ No newline at end of file
@@ -22,8 +22,12 @@
 
 #pragma once
 
+#include "BassBoostDSP.h"
 #include "CustomLookAndFeel.h"
+#include "Metering.h"
 #include "ParameterUtil.h"
+#include "PresetBank.h"
+#include "StateFormat.h"
 
 using namespace juce;
 
@@ -31,6 +35,15 @@ using namespace juce;
 class PluginAudioProcessor : public AudioProcessor
 {
 public:
+    // The chain of juce::dsp processors is the release signal path and the
+    // default. The fused engine computes the same path in a single pass; it is
+    // opt-in until DamnBassBoostBench --verify finds it identical to the chain.
+    enum class Engine
+    {
+        chain,
+        fused,
+    };
+
     //==============================================================================
     PluginAudioProcessor()
         : AudioProcessor(BusesProperties().withInput("Input", AudioChannelSet::stereo())
@@ -78,42 +91,55 @@ public:
                     "PostGain",
                     NormalisableRange<float>(-48.0f, 12.0f, 0.01f, 2.0f),
                     0.0f),
+
+                std::make_unique<AudioParameterBool>(
+                    "linkDetector",
+                    "LinkDetector",
+                    false),
             }
-        )
+        ), parameterSnapshot(parameters)
     {
-        preGain = parameters.getRawParameterValue("preGain");
-        speed = parameters.getRawParameterValue("speed");
-        ratio = parameters.getRawParameterValue("ratio");
-        boostFreq = parameters.getRawParameterValue("boostFreq");
-        boostDrive = parameters.getRawParameterValue("boostDrive");
-        amount = parameters.getRawParameterValue("amount");
-        postGain = parameters.getRawParameterValue("postGain");
+       #if DAMNBASSBOOST_PROFILE_STAGES
+        startStageTrace();
+       #endif
     }
 
     ~PluginAudioProcessor() override
     {
+       #if DAMNBASSBOOST_PROFILE_STAGES
+        stageTrace.reset();
+       #endif
     }
 
     //==============================================================================
     void prepareToPlay(double sampleRate, int samplesPerBlock) override
     {
         spec.maximumBlockSize = samplesPerBlock;
-        spec.numChannels = 2;
+        spec.numChannels = (uint32) jmax(1, getTotalNumOutputChannels());
         spec.sampleRate = sampleRate;
 
-        preAmp.prepare(spec);
-        processors.prepare(spec);
-        mixDryWet.prepare(spec);
-        postAmp.prepare(spec);
+        activeEngine = engine;
 
-        processors.get<preCompIndex>().setThreshold(-120.0f);
+        // The host picks the precision before preparing; only that engine set is used.
+        if (getProcessingPrecision() == doublePrecision)
+        {
+            prepareEngines(doubleEngines);
+            floatEngines.release();
+        }
+        else
+        {
+            prepareEngines(floatEngines);
+            doubleEngines.release();
+        }
+
+        setLatencySamples(activeLatency);
 
-        auto& boostLpf = processors.get<boostLpfIndex>();
-        boostLpf.setMode(dsp::LadderFilterMode::LPF12);
-        boostLpf.setResonance(0.0f);
+        parameterSnapshot.invalidate();
+        parameterRamp.prepare(sampleRate, subBlockSize);
 
-        mixDryWet.setMixingRule(dsp::DryWetMixingRule::linear);
-        mixDryWet.setWetMixProportion(0.5f);
+        programSequenceSeen = programSequence.load();
+        programCrossfadeLength = roundToInt(programCrossfadeSeconds * sampleRate);
+        programCrossfadePosition = programCrossfadeLength;
     }
 
     void releaseResources() override
@@ -124,56 +150,16 @@ public:
 
     void processBlock(AudioBuffer<float>& buffer, MidiBuffer&) override
     {
-        ScopedNoDenormals noDenormals;
-        auto totalNumInputChannels = getTotalNumInputChannels();
-        auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-        // In case we have more outputs than inputs, this code clears any output
-        // channels that didn't contain input data, (because these aren't
-        // guaranteed to be empty - they may contain garbage).
-        // This is here to avoid people getting screaming feedback
-        // when they first compile a plugin, but obviously you don't need to keep
-        // this code if your algorithm always overwrites all the output channels.
-        for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-            buffer.clear(i, 0, buffer.getNumSamples());
-
-        // This is the place where you'd normally do the guts of your plugin's
-        // audio processing...
-        // Make sure to reset the state if your inner loop is processing
-        // the samples and the outer loop is handling the channels.
-        // Alternatively, you can process the samples with the channels
-        // interleaved by keeping the same state.
-
-        preAmp.setGainDecibels(*preGain);
-
-        auto& preComp = processors.get<preCompIndex>();
-
-        preComp.setAttack(*speed);
-        preComp.setRelease(*speed);
-        preComp.setRatio(*ratio);
-
-        auto& boostLpf = processors.get<boostLpfIndex>();
-        boostLpf.setCutoffFrequencyHz(*boostFreq);
-        float boostGainDecibels = *boostDrive;
-        boostLpf.setDrive(Decibels::decibelsToGain(boostGainDecibels));
-
-        auto& boostAmp = processors.get<boostAmpIndex>();
-        float boostAmount = *amount * Decibels::decibelsToGain(102.0f * (0.7f - 1.0f / *ratio)) * 0.75f;
-        boostAmp.setGainLinear(boostAmount);
-
-        postAmp.setGainDecibels(*postGain + 6.0f);
-
-        dsp::AudioBlock<float> audioBlock(buffer);
-
-        dsp::ProcessContextReplacing<float> context(audioBlock);
+        process(buffer, floatEngines);
+    }
 
-        preAmp.process(context);
-        mixDryWet.pushDrySamples(context.getInputBlock());
-        processors.process(context);
-        mixDryWet.mixWetSamples(context.getOutputBlock());
-        postAmp.process(context);
+    void processBlock(AudioBuffer<double>& buffer, MidiBuffer&) override
+    {
+        process(buffer, doubleEngines);
     }
 
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+
     //==============================================================================
     AudioProcessorEditor* createEditor() override {
         return new PluginAudioProcessorEditor(*this, parameters);
@@ -185,13 +171,43 @@ public:
     const String getName() const override { return "DamnBassBoost"; }
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
-    double getTailLengthSeconds() const override { return 0; }
+    double getTailLengthSeconds() const override
+    {
+        return BassBoostCoefficients::getTailLengthSeconds(parameters.getRawParameterValue("speed")->load(),
+                                                           parameters.getRawParameterValue("boostFreq")->load());
+    }
 
     //==============================================================================
-    int getNumPrograms() override { return 1; }
-    int getCurrentProgram() override { return 0; }
-    void setCurrentProgram(int) override {}
-    const String getProgramName(int) override { return {}; }
+    // The factory programs of PresetBank. A program change publishes its index
+    // and then writes the parameters for the host and the editor. The audio
+    // thread takes the values from PresetBank rather than from the half-written
+    // parameters, switches the fused engine in one step and crossfades from the
+    // previous program (see beginProgramCrossfade()); the chain engine ramps to
+    // it like automation.
+    int getNumPrograms() override { return PresetBank::numPresets; }
+    int getCurrentProgram() override { return currentProgram.load(); }
+
+    void setCurrentProgram(int index) override
+    {
+        if (! isPositiveAndBelow(index, PresetBank::numPresets))
+            return;
+
+        currentProgram = index;
+        programsUsed = true;
+
+        // Odd while the parameters are written: the audio thread applies the
+        // program on seeing it and does not read the parameters until it is even.
+        programSequence.fetch_add(1, std::memory_order_acq_rel);
+        PresetBank::apply(parameters, PresetBank::presets[index].parameters);
+        programSequence.fetch_add(1, std::memory_order_release);
+    }
+
+    const String getProgramName(int index) override
+    {
+        return isPositiveAndBelow(index, PresetBank::numPresets) ? String(PresetBank::presets[index].name) : String();
+    }
+
+    // The factory programs are read-only.
     void changeProgramName(int, const String&) override {}
 
     //==============================================================================
@@ -200,15 +216,20 @@ public:
         // You should use this method to store your parameters in the memory block.
         // You could do that either as raw data, or use the XML or ValueTree classes
         // as intermediaries to make it easy to save and load complex data.
-        auto state = parameters.copyState();
-        std::unique_ptr<XmlElement> xml(state.createXml());
-        copyXmlToBinary(*xml, destData);
+        StateFormat::write(*this, destData);
     }
 
     void setStateInformation(const void* data, int sizeInBytes) override
     {
         // You should use this method to restore your parameters from this memory block,
         // whose contents will have been created by the getStateInformation() call.
+        if (StateFormat::isBinaryState(data, sizeInBytes))
+        {
+            StateFormat::read(*this, data, sizeInBytes);
+            return;
+        }
+
+        // Sessions saved before the binary format
         std::unique_ptr<XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
         if (xmlState.get() != nullptr)
@@ -216,13 +237,19 @@ public:
                 parameters.replaceState(ValueTree::fromXml(*xmlState));
     }
 
+    // The XML state written by earlier versions; setStateInformation() still reads it.
+    void getXmlStateInformation(MemoryBlock& destData)
+    {
+        auto state = parameters.copyState();
+        std::unique_ptr<XmlElement> xml(state.createXml());
+        copyXmlToBinary(*xml, destData);
+    }
+
     //==============================================================================
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override
     {
-        // This is the place where you check if the layout is supported.
-        // In this template code we only support mono or stereo.
-        if (layouts.getMainOutputChannelSet() != AudioChannelSet::mono()
-            && layouts.getMainOutputChannelSet() != AudioChannelSet::stereo())
+        // Any discrete or surround layout works, every channel is processed alike.
+        if (layouts.getMainOutputChannelSet().isDisabled())
             return false;
 
         // This checks if the input layout matches the output layout
@@ -232,14 +259,402 @@ public:
         return true;
     }
 
+    //==============================================================================
+    // Takes effect on the next prepareToPlay().
+    void setEngine(Engine newEngine) { engine = newEngine; }
+    Engine getEngine() const { return engine; }
+
+    // Looks ballistics and cutoff coefficients up in tables shared per sample rate
+    // instead of computing them when speed or boostFreq move. Takes effect on the
+    // next prepareToPlay().
+    void setUseCoefficientTables(bool shouldUseTables) { useCoefficientTables = shouldUseTables; }
+
+    // How the chain engine sums its dry and wet paths (the fused engine always
+    // blends in registers). Takes effect on the next prepareToPlay().
+    void setBlendMode(BassBoostBlendMode newBlendMode) { blendMode = newBlendMode; }
+    BassBoostBlendMode getBlendMode() const { return blendMode; }
+
+    // Accuracy of tanh and pow in the fused engine; the chain engine always
+    // uses the juce::dsp processors. Takes effect on the next prepareToPlay().
+    void setQuality(BassBoostQuality newQuality) { quality = newQuality; }
+    BassBoostQuality getQuality() const { return quality; }
+
+    // Instruction set of the fused engine's kernel. automatic picks the best the
+    // CPU supports; the DAMNBASSBOOST_ISA environment variable (auto, baseline,
+    // avx2, avx512) overrides it, to test a variant inside a host. Takes effect
+    // on the next prepareToPlay().
+    void setInstructionSet(BassBoostInstructionSet newInstructionSet) { instructionSet = newInstructionSet; }
+    BassBoostInstructionSet getInstructionSet() const { return instructionSet; }
+
+    // Oversampling of the ladder filter in both engines, against the aliasing
+    // of its saturator at high boostDrive. The filters add a few samples of
+    // latency, reported to the host. Takes effect on the next prepareToPlay().
+    void setOversampling(BassBoostOversampling newOversampling) { oversampling = newOversampling; }
+    BassBoostOversampling getOversampling() const { return oversampling; }
+
+    // What drives the fused engine's boost: the compressor's detector every
+    // sample, or the envelope detector at a control rate; the chain engine
+    // always uses dsp::Compressor. Takes effect on the next prepareToPlay().
+    void setDetector(BassBoostDetector newDetector) { detector = newDetector; }
+    BassBoostDetector getDetector() const { return detector; }
+
+    // The variant the fused engine runs after prepareToPlay(); baseline for the chain engine.
+    BassBoostInstructionSet getActiveInstructionSet() const { return activeInstructionSet; }
+
+    // Parameter changes are ramped over 20 ms in steps of this many samples;
+    // 0 applies them at the start of the host block. Takes effect on the next
+    // prepareToPlay().
+    void setSubBlockSize(int numSamples) { subBlockSize = numSamples; }
+    int getSubBlockSize() const { return subBlockSize; }
+
+    // Levels published once per block while an editor is attached.
+    MeterQueue& getMeterQueue() noexcept { return meterQueue; }
+
+   #if DAMNBASSBOOST_PROFILE_STAGES
+    // Cycle counts of the stages of processBlock; see StageProfiler.
+    StageProfiler& getStageProfiler() noexcept { return stageProfiler; }
+   #endif
+
 private:
-    class PluginAudioProcessorEditor : public AudioProcessorEditor
+    //==============================================================================
+    // The DSP engines for one sample type. Only the active engine of the active
+    // precision exists, so an instance does not carry the state of the others.
+    template <typename SampleType>
+    struct EngineSet
+    {
+        std::unique_ptr<ChainBassBoost<SampleType>> chain;
+        std::unique_ptr<FusedBassBoost<SampleType>> fused;
+        std::shared_ptr<const BassBoostCoefficientTables<SampleType>> coefficientTables;
+
+        // A second fused engine, prepared alike, that plays the previous
+        // program out while a program change crossfades, and its buffer. Only
+        // made by prepareToPlay() once the host has changed programs.
+        std::unique_ptr<FusedBassBoost<SampleType>> outgoingFused;
+        AudioBuffer<SampleType> outgoingBuffer;
+
+        void release()
+        {
+            chain.reset();
+            fused.reset();
+            coefficientTables.reset();
+            outgoingFused.reset();
+            outgoingBuffer.setSize(0, 0);
+        }
+    };
+
+    template <typename SampleType>
+    void prepareEngines(EngineSet<SampleType>& engines)
+    {
+        if (useCoefficientTables)
+            engines.coefficientTables = BassBoostCoefficientTables<SampleType>::getShared(spec.sampleRate,
+                                                                                         parameters.getParameterRange("speed"),
+                                                                                         parameters.getParameterRange("boostFreq"));
+        else
+            engines.coefficientTables.reset();
+
+        if (activeEngine == Engine::fused)
+        {
+            engines.chain.reset();
+
+            // Most sessions never change programs; until one does, a
+            // program change ramps like automation instead of crossfading.
+            const auto crossfadePrograms = programCrossfadeSeconds > 0.0 && programsUsed.load();
+
+            if (! crossfadePrograms)
+            {
+                engines.outgoingFused.reset();
+                engines.outgoingBuffer.setSize(0, 0);
+            }
+
+            for (auto* fused : { &engines.fused, &engines.outgoingFused })
+            {
+                if (fused == &engines.outgoingFused && ! crossfadePrograms)
+                    continue;
+
+                if (*fused == nullptr)
+                    *fused = std::make_unique<FusedBassBoost<SampleType>>();
+
+                (*fused)->setCoefficientTables(engines.coefficientTables.get());
+                (*fused)->setQuality(quality);
+                (*fused)->setInstructionSet(getRequestedInstructionSet());
+                (*fused)->setOversampling(oversampling);
+                (*fused)->setDetector(detector);
+                (*fused)->prepare(spec);
+            }
+
+            if (crossfadePrograms)
+                engines.outgoingBuffer.setSize((int) spec.numChannels, (int) spec.maximumBlockSize);
+
+            activeInstructionSet = engines.fused->getInstructionSet();
+            activeLatency = engines.fused->getLatencySamples();
+        }
+        else
+        {
+            engines.fused.reset();
+            engines.outgoingFused.reset();
+            engines.outgoingBuffer.setSize(0, 0);
+            activeInstructionSet = BassBoostInstructionSet::baseline;
+
+            if (engines.chain == nullptr)
+                engines.chain = std::make_unique<ChainBassBoost<SampleType>>();
+
+            engines.chain->setBlendMode(blendMode);
+            engines.chain->setOversampling(oversampling);
+           #if DAMNBASSBOOST_PROFILE_STAGES
+            engines.chain->setStageProfiler(&stageProfiler);
+           #endif
+            engines.chain->prepare(spec);
+            activeLatency = engines.chain->getLatencySamples();
+        }
+    }
+
+    BassBoostInstructionSet getRequestedInstructionSet() const
+    {
+        auto override = SystemStats::getEnvironmentVariable("DAMNBASSBOOST_ISA", {}).trim().toLowerCase();
+
+        if (override == "auto")     return BassBoostInstructionSet::automatic;
+        if (override == "baseline") return BassBoostInstructionSet::baseline;
+        if (override == "avx2")     return BassBoostInstructionSet::avx2;
+        if (override == "avx512")   return BassBoostInstructionSet::avx512;
+
+        return instructionSet;
+    }
+
+   #if DAMNBASSBOOST_PROFILE_STAGES
+    // For plugin and standalone builds: DAMNBASSBOOST_STAGE_TRACE=<file.json>
+    // streams every event of the session into the file, and writes the
+    // summary to <file>.txt when the instance goes away. Only the first
+    // instance of the process traces.
+    void startStageTrace()
+    {
+        static std::atomic<bool> claimed { false };
+
+        auto path = SystemStats::getEnvironmentVariable("DAMNBASSBOOST_STAGE_TRACE", {});
+
+        if (path.isEmpty() || ! File::isAbsolutePath(path) || claimed.exchange(true))
+            return;
+
+        stageTrace = std::make_unique<StageTraceThread>(stageProfiler, File(path), "processBlock");
+    }
+   #endif
+
+    template <typename SampleType>
+    void process(AudioBuffer<SampleType>& buffer, EngineSet<SampleType>& engines)
+    {
+        DAMNBASSBOOST_PROFILE_STAGE(&stageProfiler, block);
+
+        ScopedNoDenormals noDenormals;
+        auto totalNumInputChannels = getTotalNumInputChannels();
+        auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+        // In case we have more outputs than inputs, this code clears any output
+        // channels that didn't contain input data, (because these aren't
+        // guaranteed to be empty - they may contain garbage).
+        // This is here to avoid people getting screaming feedback
+        // when they first compile a plugin, but obviously you don't need to keep
+        // this code if your algorithm always overwrites all the output channels.
+        for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+            buffer.clear(i, 0, buffer.getNumSamples());
+
+        {
+            DAMNBASSBOOST_PROFILE_STAGE(&stageProfiler, parameters);
+
+            // The parameters are read only between program changes, and a
+            // change that began while they were read replaces what was read.
+            auto snapshotChanges = 0;
+
+            if ((programSequence.load(std::memory_order_acquire) & 1) == 0)
+                snapshotChanges = parameterSnapshot.update();
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const auto sequence = programSequence.load(std::memory_order_relaxed);
+            const auto newProgram = (sequence + 1) / 2 != (programSequenceSeen + 1) / 2;
+            programSequenceSeen = sequence;
+
+            if (newProgram)
+                snapshotChanges |= parameterSnapshot.assign(PresetBank::presets[currentProgram.load()].parameters);
+
+            if (newProgram && canCrossfadeProgram(engines, buffer.getNumSamples()))
+                beginProgramCrossfade(engines);
+            else if (snapshotChanges != 0 || ! parameterRamp.isPrimed())
+                parameterRamp.setTarget(parameterSnapshot.get(), snapshotChanges);
+        }
+
+        // Nothing is measured unless an editor is listening.
+        const auto metering = meterQueue.isActive();
+        MeterFrame meterFrame;
+
+        if (metering)
+        {
+            DAMNBASSBOOST_PROFILE_STAGE(&stageProfiler, metering);
+            MeterQueue::measure(buffer, meterFrame.inputPeak, meterFrame.inputRms);
+        }
+
+        dsp::AudioBlock<SampleType> audioBlock(buffer);
+        const auto crossfading = programCrossfadePosition < programCrossfadeLength;
+
+        if (crossfading)
+            processOutgoingProgram(buffer, engines);
+
+        // Sub-blocks only while a parameter ramp is running; the rest of the
+        // block is processed in one go.
+        const auto numSamples = audioBlock.getNumSamples();
+        const auto rampBlockSize = (size_t) parameterRamp.getSubBlockSize();
+
+        for (size_t start = 0; start < numSamples;)
+        {
+            auto length = numSamples - start;
+
+            if (rampBlockSize > 0 && parameterRamp.isRamping())
+                length = jmin(length, rampBlockSize);
+
+            auto subBlock = audioBlock.getSubBlock(start, length);
+            processSubBlock(subBlock, engines, parameterRamp.advance());
+            start += length;
+        }
+
+        if (crossfading)
+            mixProgramCrossfade(buffer, engines.outgoingBuffer);
+
+        if (metering)
+        {
+            DAMNBASSBOOST_PROFILE_STAGE(&stageProfiler, metering);
+            MeterQueue::measure(buffer, meterFrame.outputPeak, meterFrame.outputRms);
+
+            // The chain's dsp::Compressor does not expose its envelope.
+            if (activeEngine == Engine::fused)
+            {
+                const auto envelope = engines.fused->getDetectorEnvelope();
+                meterFrame.envelope = (float) envelope;
+                meterFrame.boost = (float) engines.fused->getBoostForEnvelope(envelope);
+            }
+
+            meterQueue.push(meterFrame);
+        }
+    }
+
+    //==============================================================================
+    // Program changes on the fused engine. The engine that was playing keeps
+    // the previous program and becomes the outgoing one; the other takes over
+    // its state, jumps to the new program without ramps, and fades in over
+    // programCrossfadeSeconds on an equal-power curve. A change during a
+    // crossfade starts a new one from the program that was fading in. Nothing
+    // here allocates: both engines and the buffer are made in prepareToPlay(),
+    // the outgoing one only after the host has changed programs.
+    template <typename SampleType>
+    bool canCrossfadeProgram(const EngineSet<SampleType>& engines, int numSamples) const noexcept
+    {
+        // Before the first parameters after prepareToPlay() there is no previous program to fade from.
+        return activeEngine == Engine::fused && engines.outgoingFused != nullptr
+            && programCrossfadeLength > 0 && parameterRamp.isPrimed()
+            && numSamples <= engines.outgoingBuffer.getNumSamples();
+    }
+
+    template <typename SampleType>
+    void beginProgramCrossfade(EngineSet<SampleType>& engines)
+    {
+        std::swap(engines.fused, engines.outgoingFused);
+
+        const auto& program = parameterSnapshot.get();
+        engines.fused->copyStateFrom(*engines.outgoingFused);
+        engines.fused->setParameters(program);
+        engines.fused->skipSmoothing();
+        parameterRamp.jumpTo(program);
+
+        programCrossfadePosition = 0;
+    }
+
+    // Runs the outgoing engine on a copy of the input, before the block is processed in place.
+    template <typename SampleType>
+    void processOutgoingProgram(const AudioBuffer<SampleType>& buffer, EngineSet<SampleType>& engines)
+    {
+        DAMNBASSBOOST_PROFILE_STAGE(&stageProfiler, fusedEngine);
+
+        const auto numChannels = buffer.getNumChannels();
+        const auto numSamples = buffer.getNumSamples();
+
+        // A host block longer than prepared: end the crossfade rather than overrun.
+        if (numSamples > engines.outgoingBuffer.getNumSamples())
+        {
+            jassertfalse;
+            programCrossfadePosition = programCrossfadeLength;
+            return;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            engines.outgoingBuffer.copyFrom(ch, 0, buffer, ch, 0, numSamples);
+
+        auto block = dsp::AudioBlock<SampleType>(engines.outgoingBuffer).getSubsetChannelBlock(0, (size_t) numChannels)
+                                                                        .getSubBlock(0, (size_t) numSamples);
+        engines.outgoingFused->process(dsp::ProcessContextReplacing<SampleType>(block));
+    }
+
+    // Fades the outgoing program out of buffer and the new one in, cos/sin of a quarter turn.
+    template <typename SampleType>
+    void mixProgramCrossfade(AudioBuffer<SampleType>& buffer, const AudioBuffer<SampleType>& outgoing) noexcept
+    {
+        if (programCrossfadePosition >= programCrossfadeLength)
+            return;
+
+        const auto numChannels = buffer.getNumChannels();
+        const auto numSamples = buffer.getNumSamples();
+        const auto step = MathConstants<SampleType>::halfPi / (SampleType) programCrossfadeLength;
+        auto* const* incomingChannels = buffer.getArrayOfWritePointers();
+        const auto* const* outgoingChannels = outgoing.getArrayOfReadPointers();
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto angle = (SampleType) jmin(programCrossfadePosition + i, programCrossfadeLength) * step;
+            const auto fadeIn = std::sin(angle);
+            const auto fadeOut = std::cos(angle);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                incomingChannels[ch][i] = incomingChannels[ch][i] * fadeIn + outgoingChannels[ch][i] * fadeOut;
+        }
+
+        programCrossfadePosition = jmin(programCrossfadePosition + numSamples, programCrossfadeLength);
+    }
+
+    template <typename SampleType>
+    void processSubBlock(dsp::AudioBlock<SampleType>& block, EngineSet<SampleType>& engines, int parameterChanges)
+    {
+        dsp::ProcessContextReplacing<SampleType> context(block);
+
+        if (activeEngine == Engine::fused)
+        {
+            if (parameterChanges != 0)
+            {
+                DAMNBASSBOOST_PROFILE_STAGE(&stageProfiler, parameters);
+                engines.fused->setParameters(parameterRamp.get(), parameterChanges);
+            }
+
+            DAMNBASSBOOST_PROFILE_STAGE(&stageProfiler, fusedEngine);
+            engines.fused->process(context);
+        }
+        else
+        {
+            if (parameterChanges != 0)
+            {
+                DAMNBASSBOOST_PROFILE_STAGE(&stageProfiler, parameters);
+                engines.chain->setParameters(parameterRamp.get(), parameterChanges);
+            }
+
+            engines.chain->process(context);
+        }
+    }
+
+    //==============================================================================
+    class PluginAudioProcessorEditor : public AudioProcessorEditor,
+                                       private MeterTicker::Client
     {
     public:
         PluginAudioProcessorEditor(PluginAudioProcessor& p,
             AudioProcessorValueTreeState& vts)
             : AudioProcessorEditor(&p), audioProcessor(p), valueTreeState(vts)
         {
+            setLookAndFeel(customLookAndFeel);
+            setOpaque(true);
+
             /*
             _SliderAttachment.reset(new SliderAttachment(valueTreeState, "", _Slider));
             //_Slider.setSliderStyle(Slider::RotaryVerticalDrag);
@@ -291,6 +706,14 @@ private:
             addAndMakeVisible(postGainSlider);
             addAndMakeVisible(postGainSliderLabel);
 
+            // Surround material: one detector for all channels
+            linkDetectorButtonAttachment.reset(new ButtonAttachment(valueTreeState, "linkDetector", linkDetectorButton));
+            linkDetectorButton.setButtonText("Link");
+            linkDetectorButton.setColour(ToggleButton::textColourId, customLookAndFeel->colourPalette[CustomLookAndFeel::white]);
+            linkDetectorButton.setColour(ToggleButton::tickColourId, customLookAndFeel->colourPalette[CustomLookAndFeel::green]);
+            linkDetectorButton.setBounds(linkDetectorArea);
+            addAndMakeVisible(linkDetectorButton);
+
             /*
             speedSliderAttachment.reset(new SliderAttachment(valueTreeState, "speed", speedSlider));
             speedSlider.setSliderStyle(Slider::RotaryVerticalDrag);
@@ -364,20 +787,37 @@ private:
             addAndMakeVisible(postGainSliderLabel);
             */
 
-            logo = Drawable::createFromImageData(BinaryData::logo_svg, BinaryData::logo_svgSize);
-            addAndMakeVisible(logo.get());
-            logo->setTransformToFit(headerArea.reduced(20).toFloat(), RectanglePlacement::centred);
+            // Knobs paint their own background (see CustomLookAndFeel::drawRotarySlider),
+            // so turning one repaints that knob only and not the editor behind it.
+            for (auto* slider : { &preGainSlider, &speedSlider, &ratioSlider, &boostFreqSlider,
+                                  &boostDriveSlider, &amountSlider, &postGainSlider })
+                slider->setOpaque(true);
+
+            meterDisplay.setBounds(meterArea);
+            addAndMakeVisible(meterDisplay);
+            audioProcessor.getMeterQueue().attachReader();
+            meterTicker->addClient(*this);
 
             setSize(width, height);
         }
 
-        ~PluginAudioProcessorEditor() override {};
+        ~PluginAudioProcessorEditor() override
+        {
+            meterTicker->removeClient(*this);
+            audioProcessor.getMeterQueue().detachReader();
+            setLookAndFeel(nullptr);
+        }
 
         void paint(Graphics& g) override
         {
-            g.fillAll(customLookAndFeel.colourPalette[CustomLookAndFeel::grey]);
-            g.setColour(customLookAndFeel.colourPalette[CustomLookAndFeel::black]);
+            const PaintProfiler::ScopedPaint scopedPaint(customLookAndFeel->paintProfiler, PaintProfiler::editor);
+
+            g.fillAll(customLookAndFeel->colourPalette[CustomLookAndFeel::grey]);
+            g.setColour(customLookAndFeel->colourPalette[CustomLookAndFeel::black]);
             g.fillRect(headerArea);
+
+            auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+            g.drawImage(customLookAndFeel->getLogoImage(logoArea.getWidth(), logoArea.getHeight(), scale), logoArea.toFloat());
         }
 
         void resized() override
@@ -385,8 +825,21 @@ private:
 
         }
 
+        void meterTick() override
+        {
+            const auto falloff = meterFalloffPerSecond / (float) MeterTicker::frameRate;
+            MeterFrame frame;
+
+            if (audioProcessor.getMeterQueue().read(frame, meterTicker->getTick()))
+                meterDisplay.update(frame, falloff);
+            else
+                meterDisplay.decay(falloff);
+        }
+
     private:
-        CustomLookAndFeel customLookAndFeel;
+        // One look and feel, with its knob and logo images, and one meter timer for all open editors
+        SharedResourcePointer<CustomLookAndFeel> customLookAndFeel;
+        SharedResourcePointer<MeterTicker> meterTicker;
 
         SliderInitializer sliderInitializer;
 
@@ -403,7 +856,15 @@ private:
 
         PluginAudioProcessor& audioProcessor;
 
+        static constexpr float meterFalloffPerSecond = 24.0f;
+
+        MeterDisplay meterDisplay { customLookAndFeel->colourPalette[CustomLookAndFeel::black],
+                                    customLookAndFeel->colourPalette[CustomLookAndFeel::green],
+                                    customLookAndFeel->colourPalette[CustomLookAndFeel::white],
+                                    customLookAndFeel->paintProfiler };
+
         typedef AudioProcessorValueTreeState::SliderAttachment SliderAttachment;
+        typedef AudioProcessorValueTreeState::ButtonAttachment ButtonAttachment;
 
         AudioProcessorValueTreeState& valueTreeState;
 
@@ -433,11 +894,14 @@ private:
         Slider postGainSlider;
         Label postGainSliderLabel;
         std::unique_ptr<SliderAttachment> postGainSliderAttachment;
-
-        std::unique_ptr<Drawable> logo;
+        ToggleButton linkDetectorButton;
+        std::unique_ptr<ButtonAttachment> linkDetectorButtonAttachment;
 
         //Rectangle<int> Area{ 0, 0, width, height };
         Rectangle<int> headerArea{ 0, 0, width, headerHeight };
+        Rectangle<int> logoArea{ headerArea.reduced(20) };
+        Rectangle<int> meterArea{ 20, 14, width / 4, headerHeight - 28 };
+        Rectangle<int> linkDetectorArea{ width - knobWidth, headerHeight - knobLabelHeight - knobSpacing, knobWidth, knobLabelHeight };
 
         Rectangle<int> preGainArea{ 0, knobPosY, knobWidth, knobHeight };
         Rectangle<int> speedArea{ knobWidth, knobPosY, knobWidth, knobHeight };
@@ -452,32 +916,45 @@ private:
 
     AudioProcessorValueTreeState parameters;
 
-    std::atomic<float>* preGain = nullptr;
-    std::atomic<float>* speed = nullptr;
-    std::atomic<float>* ratio = nullptr;
-    std::atomic<float>* boostFreq = nullptr;
-    std::atomic<float>* boostDrive = nullptr;
-    std::atomic<float>* amount = nullptr;
-    std::atomic<float>* postGain = nullptr;
-    
-    enum
-    {
-        preCompIndex,
-        boostLpfIndex,
-        boostAmpIndex,
-    };
-
-    dsp::Gain<float> preAmp;
-
-    dsp::ProcessorChain<
-        dsp::Compressor<float>,
-        dsp::LadderFilter<float>,
-        dsp::Gain<float>
-    > processors;
-
-    dsp::DryWetMixer<float> mixDryWet;
-
-    dsp::Gain<float> postAmp;
+    ParameterSnapshot parameterSnapshot;
+    ParameterRamp parameterRamp;
+    int subBlockSize = 32;
+
+    MeterQueue meterQueue;
+
+   #if DAMNBASSBOOST_PROFILE_STAGES
+    // 8192 events, 192 kB: three times what the chain engine records in the
+    // 50 ms between two drains of the trace thread, at 192 kHz with 32-sample
+    // sub-blocks. Tools that read the queue once, after a run, get its first
+    // 8192 events.
+    StageProfiler stageProfiler { 1 << 13 };
+    std::unique_ptr<StageTraceThread> stageTrace;
+   #endif
+
+    Engine engine = Engine::chain;
+    Engine activeEngine = Engine::chain;
+
+    EngineSet<float> floatEngines;
+    EngineSet<double> doubleEngines;
+
+    bool useCoefficientTables = false;
+    BassBoostBlendMode blendMode = BassBoostBlendMode::mixer;
+    BassBoostQuality quality = BassBoostQuality::reference;
+    BassBoostInstructionSet instructionSet = BassBoostInstructionSet::automatic;
+    BassBoostInstructionSet activeInstructionSet = BassBoostInstructionSet::baseline;
+    BassBoostOversampling oversampling = BassBoostOversampling::x1;
+    BassBoostDetector detector = BassBoostDetector::compressor;
+    int activeLatency = 0;
+
+    static constexpr double programCrossfadeSeconds = 0.02;
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<bool> programsUsed { false };
+
+    // Two steps per program change, odd while setCurrentProgram() writes the
+    // parameters; programSequenceSeen is the audio thread's copy.
+    std::atomic<uint32> programSequence { 0 };
+    uint32 programSequenceSeen = 0;
+    int programCrossfadeLength = 0, programCrossfadePosition = 0;
 
     dsp::ProcessSpec spec;
 
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "CustomLookAndFeel.h"
+
+using namespace juce;
+
+//==============================================================================
+// Levels of one processed block. Levels are linear gains; boost is the gain
+// of the wet path relative to the dry path.
+struct MeterFrame
+{
+    float inputPeak = 0.0f;
+    float inputRms = 0.0f;
+    float envelope = 0.0f;
+    float boost = 0.0f;
+    float outputPeak = 0.0f;
+    float outputRms = 0.0f;
+
+    // Peaks and RMS of several blocks combine by their maximum.
+    void merge(const MeterFrame& other) noexcept
+    {
+        inputPeak = jmax(inputPeak, other.inputPeak);
+        inputRms = jmax(inputRms, other.inputRms);
+        envelope = jmax(envelope, other.envelope);
+        boost = jmax(boost, other.boost);
+        outputPeak = jmax(outputPeak, other.outputPeak);
+        outputRms = jmax(outputRms, other.outputRms);
+    }
+};
+
+//==============================================================================
+// Wait-free single producer, single consumer queue of meter frames from the
+// audio thread to the editor. The audio thread only measures while a reader
+// is attached, and drops a frame rather than wait when the queue is full.
+// However many editors are open, the queue has one consumer: the first read
+// of each MeterTicker tick drains it, and the other editors of the processor
+// get the same merged frame.
+class MeterQueue
+{
+public:
+    MeterQueue() = default;
+
+    // Called by the editor; several editors may be attached at once, they
+    // share the frame drained by read().
+    void attachReader() noexcept { numReaders.fetch_add(1, std::memory_order_relaxed); }
+    void detachReader() noexcept { numReaders.fetch_sub(1, std::memory_order_relaxed); }
+
+    bool isActive() const noexcept { return numReaders.load(std::memory_order_relaxed) > 0; }
+
+    // Audio thread
+    void push(const MeterFrame& frame) noexcept
+    {
+        const auto scope = fifo.write(1);
+
+        if (scope.blockSize1 > 0)
+            frames[(size_t) scope.startIndex1] = frame;
+    }
+
+    // Message thread. Drains the queue at most once per tick and hands every
+    // caller of that tick the same merged frame; false if none was pending.
+    bool read(MeterFrame& result, uint32 tick) noexcept
+    {
+        if (tick != lastTick)
+        {
+            lastTick = tick;
+            hasLatest = pop(latest);
+        }
+
+        result = latest;
+        return hasLatest;
+    }
+
+    // Audio thread helpers, to be called around the processing of a block.
+    template <typename SampleType>
+    static void measure(const AudioBuffer<SampleType>& buffer, float& peak, float& rms) noexcept
+    {
+        const auto numChannels = buffer.getNumChannels();
+        const auto numSamples = buffer.getNumSamples();
+        auto sumOfSquares = 0.0;
+
+        peak = 0.0f;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            peak = jmax(peak, (float) buffer.getMagnitude(ch, 0, numSamples));
+
+            const auto channelRms = (double) buffer.getRMSLevel(ch, 0, numSamples);
+            sumOfSquares += channelRms * channelRms;
+        }
+
+        rms = numChannels > 0 ? (float) std::sqrt(sumOfSquares / numChannels) : 0.0f;
+    }
+
+private:
+    static constexpr int capacity = 64;
+
+    bool pop(MeterFrame& result) noexcept
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+            return false;
+
+        result = {};
+        scope.forEach([this, &result](int index) { result.merge(frames[(size_t) index]); });
+        return true;
+    }
+
+    AbstractFifo fifo { capacity };
+    std::array<MeterFrame, capacity> frames;
+    std::atomic<int> numReaders { 0 };
+
+    // Message thread only
+    MeterFrame latest;
+    bool hasLatest = false;
+    uint32 lastTick = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeterQueue)
+};
+
+//==============================================================================
+// Horizontal bars for input, detector, boost and output, fed from the editor's
+// timer. Bars rise instantly and fall at a fixed rate; a thin mark shows RMS.
+class MeterDisplay : public Component
+{
+public:
+    MeterDisplay(const Colour& backgroundColour, const Colour& barColour, const Colour& textColour, PaintProfiler& profiler)
+        : background(backgroundColour), bar(barColour), text(textColour), paintProfiler(profiler)
+    {
+        setInterceptsMouseClicks(false, false);
+        setOpaque(true);
+    }
+
+    // falloff is the drop in dB since the previous update. Repaints only if a
+    // bar or mark moved, so a silent or stopped plugin costs no paints.
+    void update(const MeterFrame& frame, float falloff)
+    {
+        const auto previous = rows;
+
+        auto fall = [falloff](float& shown, float decibels) { shown = jmax(decibels, shown - falloff); };
+
+        fall(rows[input].value, Decibels::gainToDecibels(frame.inputPeak, minimumDecibels));
+        fall(rows[envelope].value, Decibels::gainToDecibels(frame.envelope, minimumDecibels));
+        fall(rows[boost].value, Decibels::gainToDecibels(frame.boost, minimumDecibels));
+        fall(rows[output].value, Decibels::gainToDecibels(frame.outputPeak, minimumDecibels));
+
+        rows[input].mark = Decibels::gainToDecibels(frame.inputRms, minimumDecibels);
+        rows[output].mark = Decibels::gainToDecibels(frame.outputRms, minimumDecibels);
+
+        repaintIfChanged(previous);
+    }
+
+    // Lets the bars fall when no frames arrive, e.g. with the transport stopped.
+    void decay(float falloff)
+    {
+        const auto previous = rows;
+
+        for (auto& row : rows)
+        {
+            row.value = jmax(minimumDecibels, row.value - falloff);
+            row.mark = jmax(minimumDecibels, row.mark - falloff);
+        }
+
+        repaintIfChanged(previous);
+    }
+
+    void paint(Graphics& g) override
+    {
+        const PaintProfiler::ScopedPaint scopedPaint(paintProfiler, PaintProfiler::meters);
+
+        g.fillAll(background);
+
+        auto bounds = getLocalBounds().toFloat();
+        auto rowHeight = bounds.getHeight() / (float) rows.size();
+
+        g.setFont(CustomLookAndFeel::getCustomFont().withHeight(rowHeight * 0.7f));
+
+        for (auto& row : rows)
+        {
+            auto area = bounds.removeFromTop(rowHeight).reduced(0.0f, rowHeight * 0.15f);
+            auto labelArea = area.removeFromLeft(labelWidth);
+
+            g.setColour(text);
+            g.drawText(row.name, labelArea, Justification::centredLeft, false);
+
+            g.setColour(text.withAlpha(0.15f));
+            g.fillRect(area);
+
+            auto proportion = jlimit(0.0f, 1.0f, jmap(row.value, row.minimum, row.maximum, 0.0f, 1.0f));
+            g.setColour(bar);
+            g.fillRect(area.withWidth(area.getWidth() * proportion));
+
+            if (row.mark > row.minimum)
+            {
+                auto markProportion = jlimit(0.0f, 1.0f, jmap(row.mark, row.minimum, row.maximum, 0.0f, 1.0f));
+                g.setColour(text);
+                g.fillRect(area.getX() + area.getWidth() * markProportion - 1.0f, area.getY(), 2.0f, area.getHeight());
+            }
+        }
+    }
+
+private:
+    static constexpr float minimumDecibels = -100.0f;
+    static constexpr float labelWidth = 48.0f;
+
+    struct Row
+    {
+        const char* name;
+        float minimum, maximum;
+        float value = minimumDecibels;
+        float mark = minimumDecibels;
+    };
+
+    enum
+    {
+        input,
+        envelope,
+        boost,
+        output,
+    };
+
+    void repaintIfChanged(const std::array<Row, 4>& previous)
+    {
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            if (rows[i].value != previous[i].value || rows[i].mark != previous[i].mark)
+            {
+                repaint();
+                return;
+            }
+        }
+    }
+
+    std::array<Row, 4> rows { { { "In", -60.0f, 0.0f },
+                                { "Env", -60.0f, 0.0f },
+                                { "Boost", -24.0f, 48.0f },
+                                { "Out", -60.0f, 0.0f } } };
+
+    Colour background, bar, text;
+    PaintProfiler& paintProfiler;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeterDisplay)
+};
+
+//==============================================================================
+// One timer for the meters of every open editor, shared through a
+// SharedResourcePointer. Opening an editor adds it to a list rather than
+// registering another timer with the message thread, which already runs the
+// parameter timer of every instance in the session.
+class MeterTicker : private Timer
+{
+public:
+    static constexpr int frameRate = 30;
+
+    // Counts timer callbacks, starting at 1; MeterQueue::read() drains once per value.
+    uint32 getTick() const noexcept { return tick; }
+
+    struct Client
+    {
+        virtual ~Client() = default;
+        virtual void meterTick() = 0;
+    };
+
+    void addClient(Client& client)
+    {
+        clients.add(&client);
+
+        if (! isTimerRunning())
+            startTimerHz(frameRate);
+    }
+
+    void removeClient(Client& client)
+    {
+        clients.remove(&client);
+
+        if (clients.isEmpty())
+            stopTimer();
+    }
+
+private:
+    void timerCallback() override
+    {
+        if (++tick == 0)
+            ++tick;
+
+        clients.call([](Client& client) { client.meterTick(); });
+    }
+
+    ListenerList<Client> clients;
+    uint32 tick = 0;
+};
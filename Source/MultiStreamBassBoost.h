@@ -0,0 +1,401 @@
+#pragma once
+
+#include "BassBoostDSP.h"
+
+#if JUCE_USE_SIMD
+
+#if DAMNBASSBOOST_ISA_DISPATCH
+//==============================================================================
+// numLanes floats in one AVX2 (8) or AVX-512 (16) register, for the kernel
+// variants built for those sets. The vector extensions compile to the
+// register width of the function they are inlined into. Only the part of
+// dsp::SIMDRegister that BassBoostLanes and the multi-stream kernel use is
+// provided. min and max pick their operands as the SSE instructions do, so
+// every lane matches the baseline variant bit for bit.
+template <size_t numLanes>
+struct BassBoostWideRegister
+{
+    using ElementType = float;
+    static constexpr size_t SIMDNumElements = numLanes;
+
+    using Vector = typename BassBoostVector<float, numLanes>::Type;
+    using Bits = typename BassBoostVector<float, numLanes>::Bits;
+
+    struct Mask
+    {
+        JUCE_FORCEINLINE Mask operator~() const noexcept { return { ~bits }; }
+
+        Bits bits;
+    };
+
+    static JUCE_FORCEINLINE BassBoostWideRegister expand(float s) noexcept { return { s - Vector {} }; }
+
+    static JUCE_FORCEINLINE BassBoostWideRegister fromRawArray(const float* source) noexcept
+    {
+        BassBoostWideRegister result;
+        std::memcpy(&result.value, source, sizeof(Vector));
+        return result;
+    }
+
+    JUCE_FORCEINLINE void copyToRawArray(float* destination) const noexcept { std::memcpy(destination, &value, sizeof(Vector)); }
+
+    JUCE_FORCEINLINE float get(size_t lane) const noexcept { return value[lane]; }
+    JUCE_FORCEINLINE void set(size_t lane, float s) noexcept { value[lane] = s; }
+
+    JUCE_FORCEINLINE BassBoostWideRegister operator+(BassBoostWideRegister other) const noexcept { return { value + other.value }; }
+    JUCE_FORCEINLINE BassBoostWideRegister operator-(BassBoostWideRegister other) const noexcept { return { value - other.value }; }
+    JUCE_FORCEINLINE BassBoostWideRegister operator*(BassBoostWideRegister other) const noexcept { return { value * other.value }; }
+    JUCE_FORCEINLINE BassBoostWideRegister operator*(float s) const noexcept { return { value * s }; }
+    JUCE_FORCEINLINE BassBoostWideRegister operator&(Mask mask) const noexcept { return { (Vector) ((Bits) value & mask.bits) }; }
+
+    static JUCE_FORCEINLINE Mask lessThan(BassBoostWideRegister a, BassBoostWideRegister b) noexcept { return { (Bits) (a.value < b.value) }; }
+    static JUCE_FORCEINLINE Mask greaterThan(BassBoostWideRegister a, BassBoostWideRegister b) noexcept { return { (Bits) (a.value > b.value) }; }
+
+    static JUCE_FORCEINLINE BassBoostWideRegister abs(BassBoostWideRegister a) noexcept { return { (Vector) ((Bits) a.value & 0x7fffffff) }; }
+
+    // a > b ? a : b, as maxps
+    static JUCE_FORCEINLINE BassBoostWideRegister max(BassBoostWideRegister a, BassBoostWideRegister b) noexcept
+    {
+        return select(greaterThan(a, b), a, b);
+    }
+
+    // a < b ? a : b, as minps
+    static JUCE_FORCEINLINE BassBoostWideRegister min(BassBoostWideRegister a, BassBoostWideRegister b) noexcept
+    {
+        return select(lessThan(a, b), a, b);
+    }
+
+    static JUCE_FORCEINLINE BassBoostWideRegister select(Mask mask, BassBoostWideRegister a, BassBoostWideRegister b) noexcept
+    {
+        return { (Vector) (((Bits) a.value & mask.bits) | ((Bits) b.value & ~mask.bits)) };
+    }
+
+    Vector value;
+};
+#endif
+
+//==============================================================================
+// Runs many independent mono streams of the bass boost together, one stream
+// per SIMD lane: 4 in the baseline variant (dsp::SIMDRegister), 8 with AVX2
+// and 16 with AVX-512. Every per-stream value, parameters and state alike, is
+// kept in an array with one slot per stream, so a group of streams loads as
+// one register at any width and every instruction advances all the streams
+// of a group at once. Every stream has its own parameters.
+//
+// The signal path is the one of FusedBassBoost, except that streams start
+// settled at their parameters instead of ramping in from the DryWetMixer and
+// LadderFilter defaults. In the reference quality the pow() of the gain
+// computer and the tanh table of the ladder saturator are done lane by lane
+// (see BassBoostLanes); everything else is vectorised, the fast and draft
+// approximations included.
+class MultiStreamBassBoost
+{
+public:
+    MultiStreamBassBoost() = default;
+
+    void prepare(double newSampleRate, int maximumBlockSize, int newNumStreams)
+    {
+        jassert(newNumStreams > 0);
+
+        sampleRate = newSampleRate;
+        numStreams = newNumStreams;
+        numSlots = ((size_t) numStreams + maxLanes - 1) / maxLanes * maxLanes;
+
+        streamValues.assign(numFields * numSlots / maxLanes, Slots {});
+        streamParameters.resize((size_t) numStreams);
+        scratch.resize((size_t) maximumBlockSize);
+        channels.resize((size_t) numStreams);
+
+        cutoffRampSteps = (int) std::floor(cutoffRampSeconds * sampleRate);
+
+        for (int stream = 0; stream < numStreams; ++stream)
+            setParameters(stream, streamParameters[(size_t) stream].values, BassBoostParameters::allChanged, false);
+
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(getValues(Field::envelope), getValues(Field::envelope) + numSlots, 0.0f);
+        std::fill(getValues(Field::state), getValues(Field::state, numStages), 0.0f);
+        std::copy(getValues(Field::cutoffTarget), getValues(Field::cutoffTarget) + numSlots, getValues(Field::cutoffTransform));
+        std::fill(getValues(Field::cutoffRemaining), getValues(Field::cutoffRemaining) + numSlots, 0.0f);
+    }
+
+    int getNumStreams() const noexcept { return numStreams; }
+
+    void setQuality(BassBoostQuality newQuality) noexcept { quality = newQuality; }
+
+    // As FusedBassBoost::setInstructionSet.
+    void setInstructionSet(BassBoostInstructionSet requested)
+    {
+        instructionSet = BassBoostDispatch::resolve(requested);
+
+        switch (instructionSet)
+        {
+           #if DAMNBASSBOOST_ISA_DISPATCH
+            case BassBoostInstructionSet::avx2:   kernel = &MultiStreamBassBoost::processAvx2; break;
+            case BassBoostInstructionSet::avx512: kernel = &MultiStreamBassBoost::processAvx512; break;
+           #endif
+            default:                              kernel = &MultiStreamBassBoost::processBaseline; break;
+        }
+    }
+
+    BassBoostInstructionSet getInstructionSet() const noexcept { return instructionSet; }
+
+    // Parameters of one stream. Only the coefficients that changed are recomputed.
+    void setParameters(int stream, const BassBoostParameters& parameters)
+    {
+        auto& previous = streamParameters[(size_t) stream];
+        auto changes = previous.initialised ? parameters.getChangesFrom(previous.values) : (int) BassBoostParameters::allChanged;
+
+        if (changes != 0)
+            setParameters(stream, parameters, changes, true);
+    }
+
+    // Each channel of the block is one stream.
+    void process(const dsp::AudioBlock<float>& block) noexcept
+    {
+        const auto numSamples = block.getNumSamples();
+
+        jassert(block.getNumChannels() == (size_t) numStreams);
+        jassert(numSamples <= scratch.size());
+
+        for (size_t stream = 0; stream < (size_t) numStreams; ++stream)
+            channels[stream] = block.getChannelPointer(stream);
+
+        (this->*kernel)(numSamples);
+    }
+
+private:
+    //==============================================================================
+    enum class Field
+    {
+        preGain,
+        ballisticsCte,
+        exponent,
+        envelope,
+        cutoffTransform,
+        cutoffTarget,
+        cutoffStep,
+        cutoffRemaining,
+        drive,
+        driveGain,
+        drive2,
+        driveGain2,
+        boostGain,
+        postGain,
+        state, // numStages arrays, one per ladder stage
+    };
+
+    static constexpr size_t numStages = 5;
+    static constexpr size_t numFields = (size_t) Field::state + numStages;
+
+    // The widest register; the arrays are padded to a multiple of it, so the
+    // last group of every variant reads zeros in its unused lanes.
+    static constexpr size_t maxLanes = 16;
+
+    struct alignas(maxLanes * sizeof(float)) Slots
+    {
+        float values[maxLanes] = {};
+    };
+
+    // The array of one value for every stream; the ladder state has one per stage.
+    float* getValues(Field field, size_t stage = 0) noexcept
+    {
+        return reinterpret_cast<float*>(streamValues.data()) + ((size_t) field + stage) * numSlots;
+    }
+
+    // Processes the lanes of Register from firstStream on. samples holds
+    // them structure-of-arrays, one register per sample frame: lane l of
+    // samples[i] is sample i of stream firstStream + l.
+    template <typename Register>
+    JUCE_FORCEINLINE void processGroup(size_t firstStream, Register* samples, size_t numSamples) noexcept
+    {
+        auto load = [this, firstStream](Field field, size_t stage = 0) { return Register::fromRawArray(getValues(field, stage) + firstStream); };
+
+        const auto preGain = load(Field::preGain);
+        const auto ballisticsCte = load(Field::ballisticsCte);
+        const auto exponent = load(Field::exponent);
+        const auto cutoffTarget = load(Field::cutoffTarget);
+        const auto cutoffStep = load(Field::cutoffStep);
+        const auto drive = load(Field::drive);
+        const auto driveGain = load(Field::driveGain);
+        const auto drive2 = load(Field::drive2);
+        const auto driveGain2 = load(Field::driveGain2);
+        const auto boostGain = load(Field::boostGain);
+        const auto postGain = load(Field::postGain);
+
+        auto envelope = load(Field::envelope);
+        auto cutoffTransform = load(Field::cutoffTransform);
+        auto cutoffRemaining = load(Field::cutoffRemaining);
+
+        std::array<Register, numStages> s;
+
+        for (size_t stage = 0; stage < numStages; ++stage)
+            s[stage] = load(Field::state, stage);
+
+        const auto zero = Register::expand(0.0f);
+        const auto one = Register::expand(1.0f);
+        const auto resonance = Register::expand(scaledResonance * -4.0f);
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            // Per-lane linear cutoff ramp, same steps as SmoothedValue
+            cutoffRemaining = Register::max(cutoffRemaining - one, zero);
+            auto ramping = Register::greaterThan(cutoffRemaining, zero);
+            cutoffTransform = ((cutoffTransform + cutoffStep) & ramping) + (cutoffTarget & ~ramping);
+
+            const auto a1 = cutoffTransform;
+            const auto g = one - a1;
+            const auto b0 = g * 0.76923076923f;
+            const auto b1 = g * 0.23076923076f;
+
+            const auto input = samples[i] * preGain;
+
+            const auto rectified = Register::abs(input);
+            envelope = rectified + ballisticsCte * (envelope - rectified);
+
+            const auto compressorGain = BassBoostLanes::getCompressorGain(envelope, thresholdGain, thresholdInverse, exponent, quality);
+
+            const auto dx = driveGain * BassBoostLanes::saturate(drive * (compressorGain * input), quality);
+            const auto a = dx + resonance * (driveGain2 * BassBoostLanes::saturate(drive2 * s[4], quality) - dx * 0.5f);
+            const auto b = b1 * s[0] + a1 * s[1] + b0 * a;
+            const auto c = b1 * s[1] + a1 * s[2] + b0 * b;
+            const auto d = b1 * s[2] + a1 * s[3] + b0 * c;
+            const auto e = b1 * s[3] + a1 * s[4] + b0 * d;
+
+            s[0] = a;
+            s[1] = b;
+            s[2] = c;
+            s[3] = d;
+            s[4] = e;
+
+            const auto wet = c * ladderOutputGain * boostGain;
+            samples[i] = (wet * wetProportion + input * dryProportion) * postGain;
+        }
+
+        envelope.copyToRawArray(getValues(Field::envelope) + firstStream);
+        cutoffTransform.copyToRawArray(getValues(Field::cutoffTransform) + firstStream);
+        cutoffRemaining.copyToRawArray(getValues(Field::cutoffRemaining) + firstStream);
+
+        for (size_t stage = 0; stage < numStages; ++stage)
+            s[stage].copyToRawArray(getValues(Field::state, stage) + firstStream);
+    }
+
+    // The group loop of process(), compiled once per instruction set with
+    // the register of that set.
+    template <typename Register>
+    JUCE_FORCEINLINE void processKernel(size_t numSamples) noexcept
+    {
+        constexpr auto lanes = Register::SIMDNumElements;
+        auto* samples = reinterpret_cast<Register*>(scratch.data());
+
+        for (size_t firstStream = 0; firstStream < (size_t) numStreams; firstStream += lanes)
+        {
+            const auto numActive = jmin(lanes, (size_t) numStreams - firstStream);
+
+            BassBoostLanes::load(channels.data() + firstStream, numActive, 0, numSamples, samples);
+            processGroup(firstStream, samples, numSamples);
+            BassBoostLanes::store(samples, channels.data() + firstStream, numActive, 0, numSamples);
+        }
+    }
+
+    using Kernel = void (MultiStreamBassBoost::*)(size_t) noexcept;
+
+    DAMNBASSBOOST_KERNEL_BASELINE void processBaseline(size_t numSamples) noexcept { processKernel<dsp::SIMDRegister<float>>(numSamples); }
+
+   #if DAMNBASSBOOST_ISA_DISPATCH
+    DAMNBASSBOOST_KERNEL_TARGET("avx2") void processAvx2(size_t numSamples) noexcept { processKernel<BassBoostWideRegister<8>>(numSamples); }
+    DAMNBASSBOOST_KERNEL_TARGET("avx512f") void processAvx512(size_t numSamples) noexcept { processKernel<BassBoostWideRegister<16>>(numSamples); }
+   #endif
+
+    struct StreamParameters
+    {
+        BassBoostParameters values;
+        bool initialised = false;
+    };
+
+    void setParameters(int stream, const BassBoostParameters& parameters, int changes, bool rampCutoff)
+    {
+        auto set = [this, stream](Field field, float value) { getValues(field)[stream] = value; };
+        auto get = [this, stream](Field field) { return getValues(field)[stream]; };
+
+        auto& previous = streamParameters[(size_t) stream];
+        previous.values = parameters;
+        previous.initialised = true;
+
+        if (changes & BassBoostParameters::preGainChanged)
+            set(Field::preGain, Decibels::decibelsToGain(parameters.preGain));
+
+        if (changes & BassBoostParameters::speedChanged)
+            set(Field::ballisticsCte, BassBoostCoefficients::getBallisticsCte(parameters.speed, sampleRate));
+
+        if (changes & BassBoostParameters::ratioChanged)
+            set(Field::exponent, 1.0f / parameters.ratio - 1.0f);
+
+        if (changes & BassBoostParameters::boostFreqChanged)
+        {
+            auto target = BassBoostCoefficients::getCutoffTransform(parameters.boostFreq, sampleRate);
+
+            if (! rampCutoff || cutoffRampSteps <= 0)
+            {
+                set(Field::cutoffTransform, target);
+                set(Field::cutoffStep, 0.0f);
+                set(Field::cutoffRemaining, 0.0f);
+            }
+            else if (target != get(Field::cutoffTarget))
+            {
+                set(Field::cutoffStep, (target - get(Field::cutoffTransform)) / (float) cutoffRampSteps);
+                set(Field::cutoffRemaining, (float) cutoffRampSteps);
+            }
+
+            set(Field::cutoffTarget, target);
+        }
+
+        if (changes & BassBoostParameters::boostDriveChanged)
+        {
+            auto drive = Decibels::decibelsToGain(parameters.boostDrive);
+            auto drive2 = drive * 0.04f + 0.96f;
+
+            set(Field::drive, drive);
+            set(Field::driveGain, std::pow(drive, -2.642f) * 0.6103f + 0.3903f);
+            set(Field::drive2, drive2);
+            set(Field::driveGain2, std::pow(drive2, -2.642f) * 0.6103f + 0.3903f);
+        }
+
+        if (changes & (BassBoostParameters::amountChanged | BassBoostParameters::ratioChanged))
+            set(Field::boostGain, parameters.getBoostGain<float>());
+
+        if (changes & BassBoostParameters::postGainChanged)
+            set(Field::postGain, Decibels::decibelsToGain(parameters.getPostGainDecibels<float>()));
+    }
+
+    //==============================================================================
+    static constexpr float cutoffRampSeconds = 0.05f;
+    static constexpr float ladderOutputGain = 1.2f;
+    static constexpr float scaledResonance = 0.1f;
+    static constexpr float wetProportion = 0.5f;
+    static constexpr float dryProportion = 0.5f;
+
+    const float thresholdGain = Decibels::decibelsToGain(-120.0f, -200.0f);
+    const float thresholdInverse = 1.0f / thresholdGain;
+
+    double sampleRate = 44100.0;
+    int numStreams = 0;
+    size_t numSlots = 0;
+
+    int cutoffRampSteps = 0;
+    BassBoostQuality quality = BassBoostQuality::reference;
+    BassBoostInstructionSet instructionSet = BassBoostInstructionSet::baseline;
+    Kernel kernel = &MultiStreamBassBoost::processBaseline;
+
+    std::vector<Slots> streamValues;
+    std::vector<StreamParameters> streamParameters;
+    std::vector<Slots> scratch; // one sample frame of a group per element
+    std::vector<float*> channels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MultiStreamBassBoost)
+};
+
+#endif
@@ -2,8 +2,225 @@
 
 #include <JuceHeader.h>
 
+#include "BassBoostDSP.h"
+
 using namespace juce;
 
+// Reads the raw parameter values once per block and reports which of them
+// moved since the previous read, so the engines only recompute what changed.
+class ParameterSnapshot
+{
+public:
+    explicit ParameterSnapshot(AudioProcessorValueTreeState& state)
+        : preGain(state.getRawParameterValue("preGain")),
+          speed(state.getRawParameterValue("speed")),
+          ratio(state.getRawParameterValue("ratio")),
+          boostFreq(state.getRawParameterValue("boostFreq")),
+          boostDrive(state.getRawParameterValue("boostDrive")),
+          amount(state.getRawParameterValue("amount")),
+          postGain(state.getRawParameterValue("postGain")),
+          linkDetector(state.getRawParameterValue("linkDetector"))
+    {
+    }
+
+    // Returns BassBoostParameters::Change flags.
+    int update() noexcept
+    {
+        auto changes = pendingChanges;
+        pendingChanges = 0;
+
+        read(preGain, values.preGain, BassBoostParameters::preGainChanged, changes);
+        read(speed, values.speed, BassBoostParameters::speedChanged, changes);
+        read(ratio, values.ratio, BassBoostParameters::ratioChanged, changes);
+        read(boostFreq, values.boostFreq, BassBoostParameters::boostFreqChanged, changes);
+        read(boostDrive, values.boostDrive, BassBoostParameters::boostDriveChanged, changes);
+        read(amount, values.amount, BassBoostParameters::amountChanged, changes);
+        read(postGain, values.postGain, BassBoostParameters::postGainChanged, changes);
+        read(linkDetector, values.linkDetector, BassBoostParameters::linkDetectorChanged, changes);
+
+        return changes;
+    }
+
+    // Takes newValues instead of the parameters, e.g. a program the audio
+    // thread applies before the host's copies are written. Returns
+    // BassBoostParameters::Change flags.
+    int assign(const BassBoostParameters& newValues) noexcept
+    {
+        auto changes = 0;
+
+        set(values.preGain, newValues.preGain, BassBoostParameters::preGainChanged, changes);
+        set(values.speed, newValues.speed, BassBoostParameters::speedChanged, changes);
+        set(values.ratio, newValues.ratio, BassBoostParameters::ratioChanged, changes);
+        set(values.boostFreq, newValues.boostFreq, BassBoostParameters::boostFreqChanged, changes);
+        set(values.boostDrive, newValues.boostDrive, BassBoostParameters::boostDriveChanged, changes);
+        set(values.amount, newValues.amount, BassBoostParameters::amountChanged, changes);
+        set(values.postGain, newValues.postGain, BassBoostParameters::postGainChanged, changes);
+        set(values.linkDetector, newValues.linkDetector, BassBoostParameters::linkDetectorChanged, changes);
+
+        return changes;
+    }
+
+    // Makes the next update() report every value, e.g. after the engine was re-prepared.
+    void invalidate() noexcept { pendingChanges = BassBoostParameters::allChanged; }
+
+    const BassBoostParameters& get() const noexcept { return values; }
+
+private:
+    template <typename ValueType>
+    static void set(ValueType& value, ValueType newValue, int flag, int& changes) noexcept
+    {
+        if (newValue != value)
+        {
+            value = newValue;
+            changes |= flag;
+        }
+    }
+
+    static void read(const std::atomic<float>* source, float& value, int flag, int& changes) noexcept
+    {
+        set(value, source->load(std::memory_order_relaxed), flag, changes);
+    }
+
+    static void read(const std::atomic<float>* source, bool& value, int flag, int& changes) noexcept
+    {
+        set(value, source->load(std::memory_order_relaxed) >= 0.5f, flag, changes);
+    }
+
+    std::atomic<float>* preGain = nullptr;
+    std::atomic<float>* speed = nullptr;
+    std::atomic<float>* ratio = nullptr;
+    std::atomic<float>* boostFreq = nullptr;
+    std::atomic<float>* boostDrive = nullptr;
+    std::atomic<float>* amount = nullptr;
+    std::atomic<float>* postGain = nullptr;
+    std::atomic<float>* linkDetector = nullptr;
+
+    BassBoostParameters values;
+    int pendingChanges = BassBoostParameters::allChanged;
+};
+
+// Spreads parameter changes over short linear ramps that advance once per
+// sub-block, so automation read once per host block does not step at block
+// boundaries. Speed and linkDetector have nothing to smooth and are passed
+// through on the next advance().
+class ParameterRamp
+{
+public:
+    // A sub-block size of 0 applies every change at once.
+    void prepare(double sampleRate, int newSubBlockSize, double rampSeconds = 0.02)
+    {
+        subBlockSize = jmax(0, newSubBlockSize);
+        auto numSteps = subBlockSize > 0 ? jmax(1, roundToInt(rampSeconds * sampleRate / subBlockSize)) : 0;
+
+        for (auto& ramp : ramps)
+            ramp.smoother.reset(numSteps);
+
+        primed = false;
+    }
+
+    int getSubBlockSize() const noexcept { return subBlockSize; }
+
+    // The first target after prepare() is jumped to.
+    void setTarget(const BassBoostParameters& target, int changes) noexcept
+    {
+        auto targets = getRampedValues(target);
+
+        for (size_t i = 0; i < ramps.size(); ++i)
+        {
+            if (! primed)
+                ramps[i].smoother.setCurrentAndTargetValue(*targets[i]);
+            else if (changes & ramps[i].flag)
+                ramps[i].smoother.setTargetValue(*targets[i]);
+        }
+
+        values.speed = target.speed;
+        values.linkDetector = target.linkDetector;
+        pendingChanges |= primed ? changes & (BassBoostParameters::speedChanged | BassBoostParameters::linkDetectorChanged)
+                                 : (int) BassBoostParameters::allChanged;
+        primed = true;
+    }
+
+    // Moves every value to target at once, for engines that were given target
+    // directly; the next advance() reports no change.
+    void jumpTo(const BassBoostParameters& target) noexcept
+    {
+        auto targets = getRampedValues(target);
+
+        for (size_t i = 0; i < ramps.size(); ++i)
+            ramps[i].smoother.setCurrentAndTargetValue(*targets[i]);
+
+        values = target;
+        pendingChanges = 0;
+        primed = true;
+    }
+
+    // False until the first target after prepare().
+    bool isPrimed() const noexcept { return primed; }
+
+    bool isRamping() const noexcept
+    {
+        for (auto& ramp : ramps)
+            if (ramp.smoother.isSmoothing())
+                return true;
+
+        return false;
+    }
+
+    // Moves every ramp one sub-block on and returns the flags of the values that changed.
+    int advance() noexcept
+    {
+        auto changes = pendingChanges;
+        pendingChanges = 0;
+
+        auto current = getRampedValues(values);
+
+        for (size_t i = 0; i < ramps.size(); ++i)
+        {
+            auto value = ramps[i].smoother.getNextValue();
+
+            if (value != *current[i])
+            {
+                *current[i] = value;
+                changes |= ramps[i].flag;
+            }
+        }
+
+        return changes;
+    }
+
+    const BassBoostParameters& get() const noexcept { return values; }
+
+private:
+    struct Ramp
+    {
+        int flag;
+        SmoothedValue<float> smoother;
+    };
+
+    // In the order of ramps
+    static std::array<float*, 6> getRampedValues(BassBoostParameters& p) noexcept
+    {
+        return { &p.preGain, &p.ratio, &p.boostFreq, &p.boostDrive, &p.amount, &p.postGain };
+    }
+
+    static std::array<const float*, 6> getRampedValues(const BassBoostParameters& p) noexcept
+    {
+        return { &p.preGain, &p.ratio, &p.boostFreq, &p.boostDrive, &p.amount, &p.postGain };
+    }
+
+    std::array<Ramp, 6> ramps { { { BassBoostParameters::preGainChanged, {} },
+                                  { BassBoostParameters::ratioChanged, {} },
+                                  { BassBoostParameters::boostFreqChanged, {} },
+                                  { BassBoostParameters::boostDriveChanged, {} },
+                                  { BassBoostParameters::amountChanged, {} },
+                                  { BassBoostParameters::postGainChanged, {} } } };
+
+    BassBoostParameters values;
+    int pendingChanges = 0;
+    int subBlockSize = 0;
+    bool primed = false;
+};
+
 class SliderInitializer
 {
     using sliderSettings = std::tuple<
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "BassBoostDSP.h"
+
+using namespace juce;
+
+//==============================================================================
+// The factory programs behind getNumPrograms() and setCurrentProgram(). They
+// are compiled in, so a program change reads no file, parses nothing and
+// allocates nothing: it writes the parameters and lets the audio thread know.
+namespace PresetBank
+{
+    struct Preset
+    {
+        const char* name;
+        BassBoostParameters parameters;
+    };
+
+    // preGain dB, speed ms, ratio, boostFreq Hz, boostDrive dB, amount %, postGain dB, linkDetector
+    inline constexpr Preset presets[] =
+    {
+        { "Default",           {  0.0f, 1000.0f,  5.0f,  60.0f,  0.0f, 50.0f,  0.0f, false } },
+        { "Sub Warmth",        {  0.0f, 1500.0f,  3.0f,  45.0f,  0.0f, 35.0f,  0.0f, false } },
+        { "Kick Punch",        {  0.0f,  300.0f,  8.0f,  70.0f,  3.0f, 60.0f, -2.0f, true } },
+        { "Club Low End",      {  3.0f,  800.0f,  6.0f,  55.0f,  6.0f, 70.0f, -3.0f, true } },
+        { "Bass Guitar Growl", {  0.0f,  600.0f,  4.0f, 110.0f,  9.0f, 55.0f, -2.0f, false } },
+        { "Gentle Lift",       { -3.0f, 2000.0f,  2.0f,  80.0f,  0.0f, 25.0f,  0.0f, true } },
+        { "Heavy Drop",        {  6.0f,  400.0f, 12.0f,  50.0f, 12.0f, 90.0f, -6.0f, true } },
+    };
+
+    inline constexpr int numPresets = (int) std::size(presets);
+
+    // Sets every parameter that differs from the preset, as a host would.
+    inline void apply(AudioProcessorValueTreeState& state, const BassBoostParameters& values)
+    {
+        auto set = [&state](StringRef id, float value)
+        {
+            auto* parameter = state.getParameter(id);
+            jassert(parameter != nullptr);
+
+            auto normalised = parameter->convertTo0to1(value);
+
+            if (normalised != parameter->getValue())
+                parameter->setValueNotifyingHost(normalised);
+        };
+
+        set("preGain", values.preGain);
+        set("speed", values.speed);
+        set("ratio", values.ratio);
+        set("boostFreq", values.boostFreq);
+        set("boostDrive", values.boostDrive);
+        set("amount", values.amount);
+        set("postGain", values.postGain);
+        set("linkDetector", values.linkDetector ? 1.0f : 0.0f);
+    }
+}
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG)
+ #include <x86intrin.h>
+#elif JUCE_INTEL && JUCE_MSVC
+ #include <intrin.h>
+#endif
+
+using namespace juce;
+
+// Build with DAMNBASSBOOST_PROFILE_STAGES=1 to time every stage of
+// processBlock. Without it DAMNBASSBOOST_PROFILE_STAGE expands to nothing and
+// no profiler exists, so the processing code is the same as without the
+// instrumentation.
+#ifndef DAMNBASSBOOST_PROFILE_STAGES
+ #define DAMNBASSBOOST_PROFILE_STAGES 0
+#endif
+
+#if DAMNBASSBOOST_PROFILE_STAGES
+ #define DAMNBASSBOOST_PROFILE_STAGE(profiler, stage) \
+    const StageProfiler::ScopedStage JUCE_JOIN_MACRO(stageScope, __LINE__) (profiler, StageProfiler::stage)
+#else
+ #define DAMNBASSBOOST_PROFILE_STAGE(profiler, stage)
+#endif
+
+//==============================================================================
+// Cycle counts of the stages of processBlock for one processor instance. The
+// audio thread records each stage into a histogram and into a fixed-size event
+// queue; another thread drains the queue for a Chrome / Perfetto trace, or
+// reads the histograms for a summary. Neither side locks or allocates, and
+// events that find the queue full are dropped and counted. A reader that
+// drains only at the end gets the first eventCapacity events.
+class StageProfiler
+{
+public:
+    enum Stage
+    {
+        block,          // all of processBlock
+        parameters,     // snapshot, ramp and coefficient updates
+        preAmp,
+        pushDrySamples,
+        compressor,
+        ladderFilter,
+        boostGain,
+        mixWetSamples,
+        inPlaceBlend,   // the chain engine's in-place dry/wet sum
+        postAmp,
+        fusedEngine,    // every stage at once, see FusedBassBoost
+        metering,
+        numStages,
+    };
+
+    struct Event
+    {
+        uint64 start = 0, end = 0;
+        Stage stage = block;
+    };
+
+    struct ScopedStage
+    {
+        ScopedStage(StageProfiler* p, Stage s) noexcept : profiler(p), stage(s), start(p != nullptr ? getCycles() : 0) {}
+        ~ScopedStage() { if (profiler != nullptr) profiler->record(stage, start, getCycles()); }
+
+        StageProfiler* profiler;
+        Stage stage;
+        uint64 start;
+    };
+
+    explicit StageProfiler(int eventCapacity = 1 << 16)
+        : fifo(eventCapacity), events((size_t) eventCapacity),
+          calibrationCycles(getCycles()), calibrationTicks(Time::getHighResolutionTicks())
+    {
+    }
+
+    static const char* getStageName(Stage stage)
+    {
+        static const char* const names[] = { "block", "parameters", "preAmp", "pushDrySamples", "compressor", "ladderFilter",
+                                             "boostGain", "mixWetSamples", "inPlaceBlend", "postAmp", "fusedEngine", "metering" };
+        return names[(size_t) stage];
+    }
+
+    // The time stamp counter where there is one; ticks of the high resolution timer otherwise.
+    static uint64 getCycles() noexcept
+    {
+       #if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG || JUCE_MSVC)
+        return (uint64) __rdtsc();
+       #elif JUCE_ARM && JUCE_64BIT && (JUCE_GCC || JUCE_CLANG)
+        uint64 value;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (value));
+        return value;
+       #else
+        return (uint64) Time::getHighResolutionTicks();
+       #endif
+    }
+
+    // Audio thread
+    void record(Stage stage, uint64 start, uint64 end) noexcept
+    {
+        const auto cycles = end - start;
+        auto& histogram = histograms[(size_t) stage];
+
+        increment(histogram.buckets[(size_t) getBucket(cycles)], 1);
+        increment(histogram.count, 1);
+        increment(histogram.total, cycles);
+
+        if (cycles > histogram.maximum.load(std::memory_order_relaxed))
+            histogram.maximum.store(cycles, std::memory_order_relaxed);
+
+        const auto scope = fifo.write(1);
+
+        if (scope.blockSize1 > 0)
+            events[(size_t) scope.startIndex1] = { start, end, stage };
+        else
+            increment(droppedEvents, 1);
+    }
+
+    // Reader thread: appends the queued events to destination.
+    int readEvents(std::vector<Event>& destination)
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+
+        destination.insert(destination.end(), events.begin() + scope.startIndex1, events.begin() + scope.startIndex1 + scope.blockSize1);
+        destination.insert(destination.end(), events.begin() + scope.startIndex2, events.begin() + scope.startIndex2 + scope.blockSize2);
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    uint64 getNumDroppedEvents() const noexcept { return droppedEvents.load(std::memory_order_relaxed); }
+
+    // Measured against the high resolution timer over the lifetime of the profiler.
+    double getCyclesPerMicrosecond() const
+    {
+        const auto seconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - calibrationTicks);
+        return seconds > 0.0 ? (double) (getCycles() - calibrationCycles) / (seconds * 1.0e6) : 1.0;
+    }
+
+    // One line per stage that ran: calls, mean and maximum cycles, the
+    // power-of-two bounds under which half and 99 % of the calls stayed, and
+    // the share of the block time.
+    String getSummary() const
+    {
+        const auto blockTotal = (double) histograms[(size_t) block].total.load(std::memory_order_relaxed);
+
+        String summary;
+        summary << String("stage").paddedRight(' ', 16)
+                << String("calls").paddedLeft(' ', 10)
+                << String("mean cyc").paddedLeft(' ', 12)
+                << String("p50 <").paddedLeft(' ', 10)
+                << String("p99 <").paddedLeft(' ', 10)
+                << String("max cyc").paddedLeft(' ', 12)
+                << String("block %").paddedLeft(' ', 9) << newLine;
+
+        for (int stage = 0; stage < numStages; ++stage)
+        {
+            auto& histogram = histograms[(size_t) stage];
+            const auto count = histogram.count.load(std::memory_order_relaxed);
+
+            if (count == 0)
+                continue;
+
+            const auto total = (double) histogram.total.load(std::memory_order_relaxed);
+
+            summary << String(getStageName((Stage) stage)).paddedRight(' ', 16)
+                    << String((int64) count).paddedLeft(' ', 10)
+                    << String(total / (double) count, 0).paddedLeft(' ', 12)
+                    << String((int64) getPercentileBound(histogram, count, 0.5)).paddedLeft(' ', 10)
+                    << String((int64) getPercentileBound(histogram, count, 0.99)).paddedLeft(' ', 10)
+                    << String((int64) histogram.maximum.load(std::memory_order_relaxed)).paddedLeft(' ', 12)
+                    << String(blockTotal > 0.0 ? 100.0 * total / blockTotal : 0.0, 1).paddedLeft(' ', 9) << newLine;
+        }
+
+        if (auto dropped = getNumDroppedEvents())
+            summary << (int64) dropped << " events dropped from the trace queue" << newLine;
+
+        return summary;
+    }
+
+    //==============================================================================
+    // Events of one processor, shown as one thread of the trace.
+    struct Track
+    {
+        String name;
+        std::vector<Event> events;
+    };
+
+    // Chrome trace event format, which chrome://tracing and ui.perfetto.dev
+    // open, written as events arrive. Time stamps are microseconds from the
+    // origin: the first event written, unless set before.
+    class ChromeTraceWriter
+    {
+    public:
+        explicit ChromeTraceWriter(OutputStream& stream) : out(stream)
+        {
+            out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        }
+
+        ~ChromeTraceWriter()
+        {
+            out << newLine << "]}" << newLine;
+        }
+
+        void setOrigin(uint64 cycles) noexcept { origin = cycles; }
+
+        // Returns the track's thread id for write().
+        int addTrack(const String& name)
+        {
+            const auto tid = numTracks++;
+
+            separator();
+            out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << tid
+                << ",\"args\":{\"name\":" << JSON::toString(name) << "}}";
+
+            return tid;
+        }
+
+        void write(int tid, const std::vector<Event>& events, double cyclesPerMicrosecond)
+        {
+            for (auto& event : events)
+            {
+                if (origin == std::numeric_limits<uint64>::max())
+                    origin = event.start;
+
+                separator();
+                out << "{\"ph\":\"X\",\"cat\":\"dsp\",\"name\":\"" << getStageName(event.stage)
+                    << "\",\"pid\":1,\"tid\":" << tid
+                    << ",\"ts\":" << String((double) (int64) (event.start - origin) / cyclesPerMicrosecond, 3)
+                    << ",\"dur\":" << String((double) (event.end - event.start) / cyclesPerMicrosecond, 3)
+                    << ",\"args\":{\"cycles\":" << (int64) (event.end - event.start) << "}}";
+            }
+        }
+
+    private:
+        void separator()
+        {
+            if (! first)
+                out << ",";
+
+            first = false;
+            out << newLine;
+        }
+
+        OutputStream& out;
+        uint64 origin = std::numeric_limits<uint64>::max();
+        int numTracks = 0;
+        bool first = true;
+
+        JUCE_DECLARE_NON_COPYABLE(ChromeTraceWriter)
+    };
+
+    // All the tracks at once, from the earliest event of any.
+    static void writeChromeTrace(OutputStream& out, const std::vector<Track>& tracks, double cyclesPerMicrosecond)
+    {
+        auto origin = std::numeric_limits<uint64>::max();
+
+        for (auto& track : tracks)
+            for (auto& event : track.events)
+                origin = jmin(origin, event.start);
+
+        ChromeTraceWriter writer(out);
+        writer.setOrigin(origin);
+
+        for (auto& track : tracks)
+            writer.write(writer.addTrack(track.name), track.events, cyclesPerMicrosecond);
+    }
+
+private:
+    static constexpr int numBuckets = 48;
+
+    struct Histogram
+    {
+        std::array<std::atomic<uint64>, numBuckets> buckets {};
+        std::atomic<uint64> count { 0 }, total { 0 }, maximum { 0 };
+    };
+
+    // Single writer, so a relaxed load and store is enough and avoids a locked add.
+    static void increment(std::atomic<uint64>& value, uint64 amount) noexcept
+    {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // Bucket b holds the calls that took fewer than 2^b cycles and at least 2^(b-1).
+    static int getBucket(uint64 cycles) noexcept
+    {
+        int bits = 0;
+
+        while (cycles != 0 && bits < numBuckets - 1)
+        {
+            cycles >>= 1;
+            ++bits;
+        }
+
+        return bits;
+    }
+
+    static uint64 getPercentileBound(const Histogram& histogram, uint64 count, double percentile)
+    {
+        const auto target = (uint64) std::ceil(percentile * (double) count);
+        uint64 sum = 0;
+
+        for (int bucket = 0; bucket < numBuckets; ++bucket)
+        {
+            sum += histogram.buckets[(size_t) bucket].load(std::memory_order_relaxed);
+
+            if (sum >= target)
+                return (uint64) 1 << bucket;
+        }
+
+        return (uint64) 1 << (numBuckets - 1);
+    }
+
+    std::array<Histogram, numStages> histograms;
+    std::atomic<uint64> droppedEvents { 0 };
+
+    AbstractFifo fifo;
+    std::vector<Event> events;
+
+    uint64 calibrationCycles;
+    int64 calibrationTicks;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StageProfiler)
+};
+
+//==============================================================================
+// Streams the events of one profiler into a trace file from a thread of its
+// own, draining the queue every drainIntervalMs, so a session of any length
+// is traced in full with a queue that only has to hold one interval of
+// events. Writes the summary to <file>.txt when it is destroyed.
+class StageTraceThread : private Thread
+{
+public:
+    static constexpr int drainIntervalMs = 50;
+
+    StageTraceThread(StageProfiler& p, const File& file, const String& trackName)
+        : Thread("Stage trace"), profiler(p), summaryFile(file.withFileExtension("txt"))
+    {
+        file.deleteFile();
+        stream = std::make_unique<FileOutputStream>(file);
+
+        if (stream->openedOk())
+        {
+            writer = std::make_unique<StageProfiler::ChromeTraceWriter>(*stream);
+            track = writer->addTrack(trackName);
+            startThread();
+        }
+    }
+
+    ~StageTraceThread() override
+    {
+        stopThread(1000);
+
+        if (writer != nullptr)
+        {
+            drain();
+            writer.reset();
+        }
+
+        stream.reset();
+        summaryFile.replaceWithText(profiler.getSummary());
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wait(drainIntervalMs);
+            drain();
+        }
+    }
+
+    void drain()
+    {
+        events.clear();
+        profiler.readEvents(events);
+        writer->write(track, events, profiler.getCyclesPerMicrosecond());
+        stream->flush();
+    }
+
+    StageProfiler& profiler;
+    File summaryFile;
+    std::unique_ptr<FileOutputStream> stream;
+    std::unique_ptr<StageProfiler::ChromeTraceWriter> writer;
+    std::vector<StageProfiler::Event> events;
+    int track = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StageTraceThread)
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+
+//==============================================================================
+// Compact binary plugin state. Sessions restore hundreds of instances, and the
+// XML written by copyXmlToBinary() costs a parse and a ValueTree rebuild each.
+//
+// Layout, little endian:
+//     uint32  magic "DBBS"
+//     uint16  version
+//     uint16  number of records
+//     records: uint8 id length, id bytes (UTF-8), float32 real-world value
+//
+// Records are looked up by parameter id, so parameters can be added or
+// reordered without a new version; unknown ids are skipped and parameters
+// without a record keep their current value, as with the XML state. Reading
+// works straight from the host's buffer and does not allocate.
+namespace StateFormat
+{
+    static constexpr uint32 magic = (uint32) 'D' | ((uint32) 'B' << 8) | ((uint32) 'B' << 16) | ((uint32) 'S' << 24);
+    static constexpr uint16 version = 1;
+    static constexpr int headerSize = 8;
+
+    inline bool isBinaryState(const void* data, int sizeInBytes) noexcept
+    {
+        return data != nullptr && sizeInBytes >= headerSize
+            && ByteOrder::littleEndianInt(data) == magic;
+    }
+
+    inline void write(AudioProcessor& processor, MemoryBlock& destData)
+    {
+        MemoryOutputStream stream(destData, false);
+        auto& processorParameters = processor.getParameters();
+
+        stream.writeInt((int) magic);
+        stream.writeShort((short) version);
+        stream.writeShort((short) processorParameters.size());
+
+        for (auto* parameter : processorParameters)
+        {
+            auto* ranged = dynamic_cast<RangedAudioParameter*>(parameter);
+            jassert(ranged != nullptr);
+
+            auto id = ranged->paramID.toRawUTF8();
+            auto idLength = strlen(id);
+            jassert(idLength < 256);
+
+            stream.writeByte((char) idLength);
+            stream.write(id, idLength);
+            stream.writeFloat(ranged->convertFrom0to1(ranged->getValue()));
+        }
+    }
+
+    // False if the data is not a readable binary state; the processor is left
+    // untouched unless every record is intact.
+    inline bool read(AudioProcessor& processor, const void* data, int sizeInBytes)
+    {
+        if (! isBinaryState(data, sizeInBytes))
+            return false;
+
+        auto* bytes = static_cast<const uint8*>(data);
+        auto* end = bytes + sizeInBytes;
+
+        if (ByteOrder::littleEndianShort(bytes + 4) > version)
+            return false;
+
+        const auto numRecords = (int) ByteOrder::littleEndianShort(bytes + 6);
+
+        // Validate first, so a truncated blob does not restore half a state.
+        auto* record = bytes + headerSize;
+
+        for (int i = 0; i < numRecords; ++i)
+        {
+            if (record >= end || end - record < 1 + record[0] + 4)
+                return false;
+
+            record += 1 + record[0] + 4;
+        }
+
+        record = bytes + headerSize;
+
+        for (int i = 0; i < numRecords; ++i)
+        {
+            auto idLength = (size_t) record[0];
+            auto* id = reinterpret_cast<const char*>(record + 1);
+            auto value = ByteOrder::littleEndianInt(record + 1 + idLength);
+            record += 1 + idLength + 4;
+
+            for (auto* parameter : processor.getParameters())
+            {
+                auto* ranged = dynamic_cast<RangedAudioParameter*>(parameter);
+
+                if (ranged == nullptr
+                    || (size_t) ranged->paramID.getNumBytesAsUTF8() != idLength
+                    || memcmp(ranged->paramID.toRawUTF8(), id, idLength) != 0)
+                    continue;
+
+                float realValue;
+                memcpy(&realValue, &value, sizeof(realValue));
+
+                auto normalised = ranged->convertTo0to1(realValue);
+
+                if (normalised != ranged->getValue())
+                    ranged->setValueNotifyingHost(normalised);
+
+                break;
+            }
+        }
+
+        return true;
+    }
+}
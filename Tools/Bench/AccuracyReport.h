@@ -0,0 +1,151 @@
+#pragma once
+
+#include "../Common/HostUtil.h"
+#include "TestSignals.h"
+
+#include <ostream>
+
+//==============================================================================
+// Measures the quality tiers of the fused engine: the error of each tanh and
+// pow stand-in against std::tanh and std::pow, and the difference of the
+// engine output from the reference quality on program material.
+namespace AccuracyReport
+{
+    struct FunctionErrors
+    {
+        double tanhAbsolute = 0.0; // over [-5, 5]
+        double powRelative = 0.0;  // compressor gains up to 140 dB above the threshold
+    };
+
+    template <typename SampleType>
+    FunctionErrors measureFunctions(BassBoostQuality quality)
+    {
+        FunctionErrors errors;
+        const auto& table = BassBoostCoefficients::getSaturationTable<SampleType>();
+        const int numPoints = 100000;
+
+        for (int i = 0; i <= numPoints; ++i)
+        {
+            auto x = (SampleType) (-5.0 + 10.0 * i / numPoints);
+            auto value = quality == BassBoostQuality::reference ? table(x) : BassBoostApproximations::tanh(x, quality);
+
+            errors.tanhAbsolute = jmax(errors.tanhAbsolute, std::abs((double) value - std::tanh((double) x)));
+        }
+
+        // envelope / threshold from 1 to 1e7, exponents of ratios from 1 to 100
+        for (int i = 0; i <= numPoints; ++i)
+        {
+            auto x = (SampleType) std::pow(10.0, 7.0 * i / numPoints);
+
+            for (auto ratio : { 1.0, 1.5, 2.0, 5.0, 10.0, 100.0 })
+            {
+                auto y = (SampleType) (1.0 / ratio - 1.0);
+                auto value = quality == BassBoostQuality::reference ? std::pow(x, y) : BassBoostApproximations::pow(x, y, quality);
+                auto exact = std::pow((double) x, (double) y);
+
+                errors.powRelative = jmax(errors.powRelative, std::abs((double) value / exact - 1.0));
+            }
+        }
+
+        return errors;
+    }
+
+    struct OutputDifference
+    {
+        double peakDecibels = -200.0; // largest sample difference, relative to the output peak
+        double rmsDecibels = -200.0;  // RMS of the difference, relative to the output RMS
+    };
+
+    // Ten seconds of the program signal through FusedBassBoost<float> with the drive up, so the
+    // saturator is exercised, against the same at the reference quality.
+    inline OutputDifference measureOutput(BassBoostQuality quality, double sampleRate)
+    {
+        const int numChannels = 2, blockSize = 512;
+
+        AudioBuffer<float> source(numChannels, (int) (sampleRate * 10.0));
+        TestSignals::fill("program", source, sampleRate);
+
+        AudioBuffer<float> reference, approximated;
+        reference.makeCopyOf(source);
+        approximated.makeCopyOf(source);
+
+        BassBoostParameters parameters;
+        parameters.boostDrive = 12.0f;
+
+        auto render = [&](AudioBuffer<float>& buffer, BassBoostQuality renderQuality)
+        {
+            FusedBassBoost<float> engine;
+            engine.setQuality(renderQuality);
+            engine.prepare({ sampleRate, (uint32) blockSize, (uint32) numChannels });
+            engine.setParameters(parameters);
+
+            for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+            {
+                auto block = dsp::AudioBlock<float>(buffer).getSubBlock((size_t) start, (size_t) jmin(blockSize, buffer.getNumSamples() - start));
+                engine.process(dsp::ProcessContextReplacing<float>(block));
+            }
+        };
+
+        render(reference, BassBoostQuality::reference);
+        render(approximated, quality);
+
+        double peak = 0.0, sumOfSquares = 0.0, difference = 0.0, differenceSquares = 0.0;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (int i = 0; i < reference.getNumSamples(); ++i)
+            {
+                auto value = (double) reference.getSample(ch, i);
+                auto error = (double) approximated.getSample(ch, i) - value;
+
+                peak = jmax(peak, std::abs(value));
+                sumOfSquares += value * value;
+                difference = jmax(difference, std::abs(error));
+                differenceSquares += error * error;
+            }
+        }
+
+        OutputDifference result;
+
+        if (difference > 0.0)
+        {
+            result.peakDecibels = Decibels::gainToDecibels(difference / peak, -200.0);
+            result.rmsDecibels = Decibels::gainToDecibels(std::sqrt(differenceSquares / sumOfSquares), -200.0);
+        }
+
+        return result;
+    }
+
+    inline void print(std::ostream& out, double sampleRate)
+    {
+        auto formatError = [](double error) { return String(error, 2, true).paddedLeft(' ', 12); };
+
+        out << String("quality").paddedRight(' ', 12)
+            << String("tanh f32").paddedLeft(' ', 12)
+            << String("tanh f64").paddedLeft(' ', 12)
+            << String("pow f32").paddedLeft(' ', 12)
+            << String("pow f64").paddedLeft(' ', 12)
+            << String("out peak dB").paddedLeft(' ', 13)
+            << String("out rms dB").paddedLeft(' ', 12) << std::endl;
+
+        for (auto quality : { BassBoostQuality::reference, BassBoostQuality::fast, BassBoostQuality::draft })
+        {
+            auto singleErrors = measureFunctions<float>(quality);
+            auto doubleErrors = measureFunctions<double>(quality);
+            auto output = measureOutput(quality, sampleRate);
+
+            out << HostUtil::getQualityName(quality).paddedRight(' ', 12)
+                << formatError(singleErrors.tanhAbsolute)
+                << formatError(doubleErrors.tanhAbsolute)
+                << formatError(singleErrors.powRelative)
+                << formatError(doubleErrors.powRelative)
+                << String(output.peakDecibels, 1).paddedLeft(' ', 13)
+                << String(output.rmsDecibels, 1).paddedLeft(' ', 12) << std::endl;
+        }
+
+        out << std::endl
+            << "tanh: largest absolute error against std::tanh over [-5, 5]; the reference is dsp::LadderFilter's table" << std::endl
+            << "pow: largest relative error against std::pow for the compressor's gain computer" << std::endl
+            << "out: fused engine output against the reference quality, program signal, 12 dB drive" << std::endl;
+    }
+}
@@ -0,0 +1,673 @@
+#pragma once
+
+#include "../Common/HostUtil.h"
+#include "../../Source/MultiStreamBassBoost.h"
+#include "TestSignals.h"
+
+//==============================================================================
+// Renders a fixed corpus through the reference path, the chain engine summing
+// with dsp::DryWetMixer as the plugin always did, and through every other
+// engine, precision and quality, and checks that each stays within its
+// tolerance:
+//
+//     alternative              peak error     band deviation
+//     plugin defaults          identical to the reference
+//     chain in place           -96 dB         0.01 dB
+//     fused reference          -96 dB         0.01 dB
+//     fused, tables            -96 dB         0.01 dB
+//     double precision         -96 dB         0.01 dB
+//     fused fast               -60 dB         0.05 dB
+//     fused draft              -50 dB         0.1 dB
+//     fused envelope detector  -50 dB         0.1 dB
+//     fused, each kernel ISA   identical to the baseline kernel
+//
+// Oversampled alternatives are checked against the reference at the same
+// factor, whose ladder runs at the same rate through the same half-band
+// filters, so the bounds above hold; the reference itself is checked against
+// the one at 1x, where oversampling changes the ladder's tuning, its aliasing
+// and the wet path's fractional delay, so only the overall level is held:
+//
+//     fused 2x, 4x             -96 dB         0.01 dB    against chain 2x, 4x
+//     chain in place 2x        -96 dB         0.01 dB    against chain 2x
+//     chain 2x, 4x             -30 dB         0.5 dB     against chain 1x
+//
+// Outputs are aligned by the reported latency before they are compared.
+// Every render starts from a fresh prepare and is compared from its first
+// sample, with no settling window: all engines start their dry/wet mix fully
+// wet and ramp to it as dsp::DryWetMixer does, and the ramps are sample
+// accurate.
+//
+// MultiStreamBassBoost is checked on its own: every lane, with parameters of
+// its own, fixed or moving every block, against FusedBassBoost rendering that
+// stream alone and starting settled at its parameters as the lanes do.
+//
+//     multi-stream, each lane  -96 dB         0.01 dB
+//     multi-stream, each ISA   identical to the baseline kernel
+//
+// Peak error is the largest sample difference relative to the peak of the
+// reference output. Band deviation is the largest level difference in the
+// third-octave bands from 25 Hz to 16 kHz that lie within 80 dB of the
+// loudest band, from Hann-windowed spectra averaged over the render. The
+// -96 dB bound leaves room for the rounding of differently ordered float
+// arithmetic; the fused engine clearing decayed state in silence cuts off a
+// tail below half a 24-bit LSB, far under it.
+//
+// The other bounds (fast, draft, envelope, and oversampled against 1x) are
+// provisional until calibrated against a JUCE build: --verify --calibrate
+// prints the worst difference each alternative shows over the whole corpus
+// and the tolerance to set from it, 6 dB above the worst peak error and 1.5
+// times the worst band deviation, rounded up.
+namespace EquivalenceCheck
+{
+    struct Tolerance
+    {
+        double peakDecibels = -96.0;
+        double bandDecibels = 0.01;
+        bool identical = false;
+    };
+
+    struct Alternative
+    {
+        String name;
+        HostUtil::ProcessorSettings settings;
+        bool doublePrecision = false;
+        Tolerance tolerance;
+        // Of the reference the alternative is compared against
+        BassBoostOversampling referenceOversampling = BassBoostOversampling::x1;
+    };
+
+    // Parameter values, applied before every block from a function of the block's start time.
+    struct Automation
+    {
+        String name;
+        std::function<void(AudioProcessor&, double seconds)> apply;
+    };
+
+    struct Difference
+    {
+        double peakDecibels = -400.0;
+        double bandDecibels = 0.0;
+        bool identical = true;
+    };
+
+    //==============================================================================
+    inline Array<Automation> getAutomations()
+    {
+        auto set = [](AudioProcessor& processor, const String& id, float value)
+        {
+            HostUtil::applyParameter(processor, { id, value });
+        };
+
+        Array<Automation> automations;
+
+        automations.add({ "defaults", [](AudioProcessor&, double) {} });
+
+        automations.add({ "hot", [set](AudioProcessor& processor, double)
+        {
+            set(processor, "preGain", 12.0f);
+            set(processor, "speed", 1.0f);
+            set(processor, "ratio", 20.0f);
+            set(processor, "boostFreq", 120.0f);
+            set(processor, "boostDrive", 12.0f);
+            set(processor, "amount", 100.0f);
+            set(processor, "postGain", -6.0f);
+        } });
+
+        // Everything moving at once, as with host automation
+        automations.add({ "automated", [set](AudioProcessor& processor, double seconds)
+        {
+            auto lfo = [seconds](double rate) { return (float) (0.5 + 0.5 * std::sin(MathConstants<double>::twoPi * rate * seconds)); };
+
+            set(processor, "preGain", -12.0f + 18.0f * lfo(0.3));
+            set(processor, "speed", 1.0f + 499.0f * lfo(0.7));
+            set(processor, "ratio", 1.0f + 19.0f * lfo(0.4));
+            set(processor, "boostFreq", 20.0f + 280.0f * lfo(1.1));
+            set(processor, "boostDrive", 12.0f * lfo(0.9));
+            set(processor, "amount", 100.0f * lfo(0.5));
+            set(processor, "postGain", -6.0f * lfo(0.2));
+        } });
+
+        return automations;
+    }
+
+    inline Array<Alternative> getAlternatives()
+    {
+        Array<Alternative> alternatives;
+
+        auto add = [&alternatives](const String& name, PluginAudioProcessor::Engine engine, Tolerance tolerance)
+        {
+            Alternative alternative;
+            alternative.name = name;
+            alternative.settings.engine = engine;
+            alternative.tolerance = tolerance;
+            alternatives.add(alternative);
+            return &alternatives.getReference(alternatives.size() - 1);
+        };
+
+        // What a new instance runs must stay the released signal path
+        Alternative defaults;
+        defaults.name = "defaults";
+        defaults.tolerance.identical = true;
+        alternatives.add(defaults);
+
+        add("chain inplace", PluginAudioProcessor::Engine::chain, {})->settings.blendMode = BassBoostBlendMode::inPlace;
+        add("fused reference", PluginAudioProcessor::Engine::fused, {});
+        add("fused tables", PluginAudioProcessor::Engine::fused, {})->settings.coefficientTables = true;
+        add("fused double", PluginAudioProcessor::Engine::fused, {})->doublePrecision = true;
+
+        auto* chainDouble = add("chain double", PluginAudioProcessor::Engine::chain, {});
+        chainDouble->settings.blendMode = BassBoostBlendMode::mixer;
+        chainDouble->doublePrecision = true;
+
+        add("fused fast", PluginAudioProcessor::Engine::fused, { -60.0, 0.05 })->settings.quality = BassBoostQuality::fast;
+        add("fused draft", PluginAudioProcessor::Engine::fused, { -50.0, 0.1 })->settings.quality = BassBoostQuality::draft;
+        add("fused envelope", PluginAudioProcessor::Engine::fused, { -50.0, 0.1 })->settings.detector = BassBoostDetector::envelope;
+
+        for (auto oversampling : { BassBoostOversampling::x2, BassBoostOversampling::x4 })
+        {
+            const auto factor = HostUtil::getOversamplingName(oversampling) + "x";
+
+            auto* chain = add("chain " + factor, PluginAudioProcessor::Engine::chain, { -30.0, 0.5 });
+            chain->settings.blendMode = BassBoostBlendMode::mixer;
+            chain->settings.oversampling = oversampling;
+
+            auto* fused = add("fused " + factor, PluginAudioProcessor::Engine::fused, {});
+            fused->settings.oversampling = oversampling;
+            fused->referenceOversampling = oversampling;
+        }
+
+        auto* chainInPlace = add("chain inplace 2x", PluginAudioProcessor::Engine::chain, {});
+        chainInPlace->settings.blendMode = BassBoostBlendMode::inPlace;
+        chainInPlace->settings.oversampling = BassBoostOversampling::x2;
+        chainInPlace->referenceOversampling = BassBoostOversampling::x2;
+
+        return alternatives;
+    }
+
+    //==============================================================================
+    // Renders input followed by the processor's latency in silence and returns
+    // the output from the latency on, aligned with input.
+    template <typename SampleType>
+    String render(const HostUtil::ProcessorSettings& settings, const Automation& automation,
+                  const AudioBuffer<float>& input, double sampleRate, int blockSize, AudioBuffer<float>& output)
+    {
+        PluginAudioProcessor processor;
+        auto error = HostUtil::applySettings(processor, settings);
+
+        if (error.isNotEmpty())
+            return error;
+
+        if (! HostUtil::setChannelLayout(processor, input.getNumChannels()))
+            return "unsupported layout";
+
+        processor.setProcessingPrecision(std::is_same<SampleType, double>::value ? AudioProcessor::doublePrecision
+                                                                                 : AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        const auto latency = processor.getLatencySamples();
+
+        AudioBuffer<SampleType> buffer(input.getNumChannels(), input.getNumSamples() + latency);
+        buffer.clear();
+
+        for (int ch = 0; ch < input.getNumChannels(); ++ch)
+            for (int i = 0; i < input.getNumSamples(); ++i)
+                buffer.setSample(ch, i, (SampleType) input.getSample(ch, i));
+
+        MidiBuffer midi;
+
+        for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+        {
+            auto numSamples = jmin(blockSize, buffer.getNumSamples() - start);
+            AudioBuffer<SampleType> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, numSamples);
+
+            automation.apply(processor, start / sampleRate);
+            processor.processBlock(block, midi);
+        }
+
+        output.setSize(input.getNumChannels(), input.getNumSamples(), false, false, true);
+
+        for (int ch = 0; ch < input.getNumChannels(); ++ch)
+            for (int i = 0; i < input.getNumSamples(); ++i)
+                output.setSample(ch, i, (float) buffer.getSample(ch, latency + i));
+
+        return {};
+    }
+
+    // Power per third-octave band, summed over the channels.
+    inline std::vector<double> getBandPowers(const AudioBuffer<float>& buffer, double sampleRate)
+    {
+        constexpr int order = 13;
+        constexpr int size = 1 << order;
+
+        dsp::FFT fft(order);
+        dsp::WindowingFunction<float> window((size_t) size, dsp::WindowingFunction<float>::hann, false);
+        std::vector<float> frame((size_t) size * 2);
+        std::vector<double> spectrum((size_t) size / 2 + 1, 0.0);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            for (int start = 0; start + size <= buffer.getNumSamples(); start += size / 2)
+            {
+                std::fill(frame.begin(), frame.end(), 0.0f);
+                FloatVectorOperations::copy(frame.data(), buffer.getReadPointer(ch, start), size);
+                window.multiplyWithWindowingTable(frame.data(), (size_t) size);
+                fft.performFrequencyOnlyForwardTransform(frame.data());
+
+                for (size_t bin = 0; bin < spectrum.size(); ++bin)
+                    spectrum[bin] += (double) frame[bin] * (double) frame[bin];
+            }
+        }
+
+        std::vector<double> bands;
+
+        for (double centre = 25.0; centre <= 16000.0 * 1.01; centre *= std::pow(2.0, 1.0 / 3.0))
+        {
+            const auto lowBin = (size_t) std::ceil(centre * std::pow(2.0, -1.0 / 6.0) * size / sampleRate);
+            const auto highBin = jmin(spectrum.size() - 1, (size_t) std::floor(centre * std::pow(2.0, 1.0 / 6.0) * size / sampleRate));
+
+            double power = 0.0;
+
+            for (auto bin = lowBin; bin <= highBin; ++bin)
+                power += spectrum[bin];
+
+            bands.push_back(power);
+        }
+
+        return bands;
+    }
+
+    inline Difference compare(const AudioBuffer<float>& reference, const AudioBuffer<float>& alternative, double sampleRate)
+    {
+        Difference difference;
+        double peak = 0.0, error = 0.0;
+
+        for (int ch = 0; ch < reference.getNumChannels(); ++ch)
+        {
+            for (int i = 0; i < reference.getNumSamples(); ++i)
+            {
+                const auto value = reference.getSample(ch, i);
+                const auto other = alternative.getSample(ch, i);
+
+                if (memcmp(&value, &other, sizeof(value)) != 0)
+                    difference.identical = false;
+
+                peak = jmax(peak, (double) std::abs(value));
+                error = jmax(error, std::abs((double) other - (double) value));
+            }
+        }
+
+        if (error > 0.0)
+            difference.peakDecibels = 20.0 * std::log10(error / jmax(peak, 1.0e-20));
+
+        const auto referenceBands = getBandPowers(reference, sampleRate);
+        const auto alternativeBands = getBandPowers(alternative, sampleRate);
+        const auto loudest = *std::max_element(referenceBands.begin(), referenceBands.end());
+
+        for (size_t band = 0; band < referenceBands.size(); ++band)
+            if (referenceBands[band] > loudest * 1.0e-8 && alternativeBands[band] > 0.0)
+                difference.bandDecibels = jmax(difference.bandDecibels, std::abs(10.0 * std::log10(alternativeBands[band] / referenceBands[band])));
+
+        return difference;
+    }
+
+    // The worst measured difference plus the margins given above.
+    inline Tolerance getCalibratedTolerance(const Difference& worst)
+    {
+        Tolerance tolerance;
+        tolerance.peakDecibels = std::ceil(worst.peakDecibels + 6.0);
+        tolerance.bandDecibels = jmax(0.01, std::ceil(worst.bandDecibels * 1.5 * 100.0) / 100.0);
+        return tolerance;
+    }
+
+    inline bool isWithin(const Difference& difference, const Tolerance& tolerance)
+    {
+        if (tolerance.identical)
+            return difference.identical;
+
+        return difference.peakDecibels <= tolerance.peakDecibels && difference.bandDecibels <= tolerance.bandDecibels;
+    }
+
+   #if JUCE_USE_SIMD
+    //==============================================================================
+    // Parameters of one stream, spread over the parameter ranges so every lane
+    // of a register differs; automated ones move with a phase per stream.
+    inline BassBoostParameters getStreamParameters(int stream, bool automated, double seconds)
+    {
+        BassBoostParameters parameters;
+        parameters.preGain = -12.0f + 3.0f * (float) (stream % 9);
+        parameters.speed = 100.0f + 290.0f * (float) (stream % 9);
+        parameters.ratio = 1.0f + 2.3f * (float) (stream % 9);
+        parameters.boostFreq = 25.0f + 33.0f * (float) (stream % 9);
+        parameters.boostDrive = 1.5f * (float) (stream % 9);
+        parameters.amount = 100.0f - 11.0f * (float) (stream % 9);
+        parameters.postGain = -0.5f * (float) (stream % 9);
+
+        if (automated)
+        {
+            auto lfo = [seconds, stream](double rate)
+            {
+                return (float) (0.5 + 0.5 * std::sin(MathConstants<double>::twoPi * rate * seconds + stream));
+            };
+
+            parameters.speed = 1.0f + 499.0f * lfo(0.7);
+            parameters.ratio = 1.0f + 19.0f * lfo(0.4);
+            parameters.boostFreq = 20.0f + 280.0f * lfo(1.1);
+            parameters.boostDrive = 12.0f * lfo(0.9);
+            parameters.amount = 100.0f * lfo(0.5);
+        }
+
+        return parameters;
+    }
+
+    // Every channel of buffer is one stream, processed in place.
+    inline void renderMultiStream(BassBoostInstructionSet instructionSet, bool automated,
+                                  AudioBuffer<float>& buffer, double sampleRate, int blockSize)
+    {
+        const auto numStreams = buffer.getNumChannels();
+
+        MultiStreamBassBoost multiStream;
+        multiStream.setInstructionSet(instructionSet);
+        multiStream.prepare(sampleRate, blockSize, numStreams);
+
+        for (int stream = 0; stream < numStreams; ++stream)
+            multiStream.setParameters(stream, getStreamParameters(stream, automated, 0.0));
+
+        multiStream.reset();
+
+        for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+        {
+            const auto numSamples = jmin(blockSize, buffer.getNumSamples() - start);
+
+            for (int stream = 0; stream < numStreams; ++stream)
+                multiStream.setParameters(stream, getStreamParameters(stream, automated, start / sampleRate));
+
+            multiStream.process(dsp::AudioBlock<float>(buffer).getSubBlock((size_t) start, (size_t) numSamples));
+        }
+    }
+
+    // The same streams one at a time through a mono FusedBassBoost.
+    inline void renderSingleStreams(bool automated, AudioBuffer<float>& buffer, double sampleRate, int blockSize)
+    {
+        for (int stream = 0; stream < buffer.getNumChannels(); ++stream)
+        {
+            FusedBassBoost<float> fused;
+            fused.prepare({ sampleRate, (uint32) blockSize, 1 });
+            fused.setParameters(getStreamParameters(stream, automated, 0.0));
+            fused.reset();
+
+            auto channel = dsp::AudioBlock<float>(buffer).getSingleChannelBlock((size_t) stream);
+
+            for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+            {
+                const auto numSamples = jmin(blockSize, buffer.getNumSamples() - start);
+                auto block = channel.getSubBlock((size_t) start, (size_t) numSamples);
+
+                fused.setParameters(getStreamParameters(stream, automated, start / sampleRate));
+                fused.process(dsp::ProcessContextReplacing<float>(block));
+            }
+        }
+    }
+
+    // The worst lane: each is compared against its own peak and bands.
+    inline Difference compareLanes(AudioBuffer<float>& reference, AudioBuffer<float>& alternative, double sampleRate)
+    {
+        Difference worst;
+
+        for (int stream = 0; stream < reference.getNumChannels(); ++stream)
+        {
+            const AudioBuffer<float> referenceLane(reference.getArrayOfWritePointers() + stream, 1, reference.getNumSamples());
+            const AudioBuffer<float> alternativeLane(alternative.getArrayOfWritePointers() + stream, 1, alternative.getNumSamples());
+            const auto difference = compare(referenceLane, alternativeLane, sampleRate);
+
+            worst.peakDecibels = jmax(worst.peakDecibels, difference.peakDecibels);
+            worst.bandDecibels = jmax(worst.bandDecibels, difference.bandDecibels);
+            worst.identical = worst.identical && difference.identical;
+        }
+
+        return worst;
+    }
+   #endif
+
+    //==============================================================================
+    // Prints one line per comparison; returns the number outside their
+    // tolerance. With calibrate, also prints every alternative's worst
+    // difference and the tolerance it calls for, and returns 0.
+    inline int run(std::ostream& out, double sampleRate, int blockSize, bool calibrate = false)
+    {
+        struct Input
+        {
+            String signal;
+            int numChannels;
+        };
+
+        const Input inputs[] = { { "program", 2 }, { "sweep", 2 }, { "noise", 2 }, { "program", 6 } };
+        const auto alternatives = getAlternatives();
+        const auto automations = getAutomations();
+        const auto seconds = 6.0;
+
+        out << String("signal").paddedRight(' ', 14)
+            << String("automation").paddedRight(' ', 12)
+            << String("alternative").paddedRight(' ', 20)
+            << String("peak dB").paddedLeft(' ', 9)
+            << String("limit").paddedLeft(' ', 8)
+            << String("band dB").paddedLeft(' ', 9)
+            << String("limit").paddedLeft(' ', 8) << std::endl;
+
+        int numFailed = 0;
+
+        // Of the alternatives compared within a tolerance, in the order first seen
+        StringArray calibrationNames;
+        std::map<String, std::pair<Difference, Tolerance>> worstDifferences;
+
+        auto print = [&](const String& signal, const String& automation, const String& name,
+                         const Difference& difference, const Tolerance& tolerance)
+        {
+            const auto passed = isWithin(difference, tolerance);
+            numFailed += passed ? 0 : 1;
+
+            if (! tolerance.identical)
+            {
+                if (! calibrationNames.contains(name))
+                {
+                    calibrationNames.add(name);
+                    worstDifferences[name] = { difference, tolerance };
+                }
+
+                auto& worst = worstDifferences[name].first;
+                worst.peakDecibels = jmax(worst.peakDecibels, difference.peakDecibels);
+                worst.bandDecibels = jmax(worst.bandDecibels, difference.bandDecibels);
+            }
+
+            out << signal.paddedRight(' ', 14) << automation.paddedRight(' ', 12) << name.paddedRight(' ', 20);
+
+            if (tolerance.identical)
+                out << (difference.identical ? String("identical") : String(difference.peakDecibels, 1)).paddedLeft(' ', 9)
+                    << String("bitwise").paddedLeft(' ', 8) << String().paddedLeft(' ', 17);
+            else
+                out << String(difference.peakDecibels, 1).paddedLeft(' ', 9)
+                    << String(tolerance.peakDecibels, 0).paddedLeft(' ', 8)
+                    << String(difference.bandDecibels, 4).paddedLeft(' ', 9)
+                    << String(tolerance.bandDecibels, 2).paddedLeft(' ', 8);
+
+            out << (passed ? "" : "  FAIL") << std::endl;
+        };
+
+        for (auto& input : inputs)
+        {
+            AudioBuffer<float> source(input.numChannels, (int) (sampleRate * seconds));
+            TestSignals::fill(input.signal, source, sampleRate);
+            const auto signalName = input.signal + (input.numChannels == 2 ? String() : " " + String(input.numChannels) + "ch");
+
+            for (auto& automation : automations)
+            {
+                // The reference at each oversampling factor, rendered when first needed
+                AudioBuffer<float> references[3], alternativeOutput;
+                String referenceErrors[3];
+                bool referenceRendered[3] = {};
+
+                auto getReference = [&](BassBoostOversampling oversampling) -> String
+                {
+                    const auto index = (size_t) oversampling;
+
+                    if (! referenceRendered[index])
+                    {
+                        HostUtil::ProcessorSettings referenceSettings;
+                        referenceSettings.engine = PluginAudioProcessor::Engine::chain;
+                        referenceSettings.blendMode = BassBoostBlendMode::mixer;
+                        referenceSettings.oversampling = oversampling;
+
+                        referenceErrors[index] = render<float>(referenceSettings, automation, source, sampleRate, blockSize, references[index]);
+                        referenceRendered[index] = true;
+                    }
+
+                    return referenceErrors[index];
+                };
+
+                auto error = getReference(BassBoostOversampling::x1);
+
+                if (error.isNotEmpty())
+                {
+                    out << signalName << " " << automation.name << ": " << error << std::endl;
+                    ++numFailed;
+                    continue;
+                }
+
+                for (auto& alternative : alternatives)
+                {
+                    error = getReference(alternative.referenceOversampling);
+
+                    if (error.isNotEmpty())
+                    {
+                        out << signalName << " " << automation.name << " " << alternative.name << " reference: " << error << std::endl;
+                        ++numFailed;
+                        continue;
+                    }
+
+                    error = alternative.doublePrecision ? render<double>(alternative.settings, automation, source, sampleRate, blockSize, alternativeOutput)
+                                                        : render<float>(alternative.settings, automation, source, sampleRate, blockSize, alternativeOutput);
+
+                    if (error.isNotEmpty())
+                    {
+                        out << signalName << " " << automation.name << " " << alternative.name << ": " << error << std::endl;
+                        ++numFailed;
+                        continue;
+                    }
+
+                    print(signalName, automation.name, alternative.name,
+                          compare(references[(size_t) alternative.referenceOversampling], alternativeOutput, sampleRate), alternative.tolerance);
+                }
+
+                // Every kernel variant the CPU runs against the baseline kernel
+                HostUtil::ProcessorSettings baselineSettings;
+                baselineSettings.engine = PluginAudioProcessor::Engine::fused;
+                baselineSettings.instructionSet = BassBoostInstructionSet::baseline;
+
+                AudioBuffer<float> baseline;
+                error = render<float>(baselineSettings, automation, source, sampleRate, blockSize, baseline);
+
+                if (error.isNotEmpty())
+                {
+                    out << signalName << " " << automation.name << " fused baseline: " << error << std::endl;
+                    ++numFailed;
+                    continue;
+                }
+
+                for (auto instructionSet : { BassBoostInstructionSet::avx2, BassBoostInstructionSet::avx512 })
+                {
+                    if (! BassBoostDispatch::isAvailable(instructionSet))
+                        continue;
+
+                    HostUtil::ProcessorSettings settings;
+                    settings.engine = PluginAudioProcessor::Engine::fused;
+                    settings.instructionSet = instructionSet;
+                    error = render<float>(settings, automation, source, sampleRate, blockSize, alternativeOutput);
+
+                    if (error.isNotEmpty())
+                    {
+                        out << signalName << " " << automation.name << " fused " << BassBoostDispatch::getName(instructionSet) << ": " << error << std::endl;
+                        ++numFailed;
+                        continue;
+                    }
+
+                    Tolerance identical;
+                    identical.identical = true;
+                    print(signalName, automation.name, "fused " + BassBoostDispatch::getName(instructionSet),
+                          compare(baseline, alternativeOutput, sampleRate), identical);
+                }
+            }
+        }
+
+       #if JUCE_USE_SIMD
+        // Nine streams: two full registers and a partial one at 4 lanes, a
+        // full and a partial one at 8 (AVX2), a partial one at 16 (AVX-512).
+        constexpr int numStreams = 9;
+
+        for (auto* signal : { "program", "noise" })
+        {
+            AudioBuffer<float> source(numStreams, (int) (sampleRate * seconds));
+            TestSignals::fill(signal, source, sampleRate);
+            const auto signalName = String(signal) + " " + String(numStreams) + "st";
+
+            for (auto automated : { false, true })
+            {
+                const String automationName = automated ? "automated" : "per stream";
+
+                AudioBuffer<float> reference, baseline, alternativeOutput;
+                reference.makeCopyOf(source);
+                renderSingleStreams(automated, reference, sampleRate, blockSize);
+
+                baseline.makeCopyOf(source);
+                renderMultiStream(BassBoostInstructionSet::baseline, automated, baseline, sampleRate, blockSize);
+                print(signalName, automationName, "multi-stream", compareLanes(reference, baseline, sampleRate), {});
+
+                for (auto instructionSet : { BassBoostInstructionSet::avx2, BassBoostInstructionSet::avx512 })
+                {
+                    if (! BassBoostDispatch::isAvailable(instructionSet))
+                        continue;
+
+                    alternativeOutput.makeCopyOf(source);
+                    renderMultiStream(instructionSet, automated, alternativeOutput, sampleRate, blockSize);
+
+                    Tolerance identical;
+                    identical.identical = true;
+                    print(signalName, automationName, "multi-stream " + BassBoostDispatch::getName(instructionSet),
+                          compareLanes(baseline, alternativeOutput, sampleRate), identical);
+                }
+            }
+        }
+       #endif
+
+        out << std::endl << (numFailed == 0 ? "all alternatives within tolerance" : String(numFailed) + " comparisons failed") << std::endl;
+
+        if (calibrate)
+        {
+            out << std::endl
+                << String("alternative").paddedRight(' ', 20)
+                << String("worst peak").paddedLeft(' ', 12)
+                << String("limit").paddedLeft(' ', 8)
+                << String("set to").paddedLeft(' ', 8)
+                << String("worst band").paddedLeft(' ', 12)
+                << String("limit").paddedLeft(' ', 8)
+                << String("set to").paddedLeft(' ', 8) << std::endl;
+
+            for (auto& name : calibrationNames)
+            {
+                const auto& entry = worstDifferences[name];
+                const auto calibrated = getCalibratedTolerance(entry.first);
+
+                out << name.paddedRight(' ', 20)
+                    << String(entry.first.peakDecibels, 1).paddedLeft(' ', 12)
+                    << String(entry.second.peakDecibels, 0).paddedLeft(' ', 8)
+                    << String(calibrated.peakDecibels, 0).paddedLeft(' ', 8)
+                    << String(entry.first.bandDecibels, 4).paddedLeft(' ', 12)
+                    << String(entry.second.bandDecibels, 2).paddedLeft(' ', 8)
+                    << String(calibrated.bandDecibels, 2).paddedLeft(' ', 8) << std::endl;
+            }
+
+            return 0;
+        }
+
+        return numFailed;
+    }
+}
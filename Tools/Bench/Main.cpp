@@ -0,0 +1,556 @@
+#include <JuceHeader.h>
+
+#include <iostream>
+#include <map>
+
+#include "AccuracyReport.h"
+#include "EquivalenceCheck.h"
+#include "MemoryBenchmark.h"
+#include "ProcessBenchmark.h"
+#include "RealtimeCheck.h"
+#include "StartupBenchmark.h"
+#include "StateBenchmark.h"
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: DamnBassBoostBench [options]" << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "  --engines <list>       comma separated: " << HostUtil::getEngineNames().joinIntoString(",") << " (default fused)" << std::endl
+              << "  --signals <list>       comma separated: " << TestSignals::getNames().joinIntoString(",") << std::endl
+              << "  --blocks <list>        block sizes (default 32,64,128,256,512,1024,2048,4096)" << std::endl
+              << "  --rates <list>         sample rates (default 44100,48000,96000,192000)" << std::endl
+              << "  --channels <list>      channel counts (default 1,2)" << std::endl
+              << "  --precision <list>     comma separated: float,double (default float)" << std::endl
+              << "  --oversampling <list>  ladder oversampling factors: " << HostUtil::getOversamplingNames().joinIntoString(",")
+              << " (default 1); prints the cost of each against 1x" << std::endl
+              << "  --streams <list>       also time MultiStreamBassBoost with these stream counts" << std::endl
+              << "  --seconds <s>          audio processed per case (default 2)" << std::endl
+              << "  --deadline <fraction>  share of the block period one core may spend, for instances/core (default 1)" << std::endl
+              << "  --coefficient-tables   look ballistics/cutoff coefficients up in shared tables" << std::endl
+              << "  --blend <mode>         chain engine dry/wet sum: " << HostUtil::getBlendModeNames().joinIntoString(",") << " (default mixer)" << std::endl
+              << "  --quality <tier>       tanh/pow accuracy: " << HostUtil::getQualityNames().joinIntoString(",") << " (default reference)" << std::endl
+              << "  --detector <kind>      fused engine detector: " << HostUtil::getDetectorNames().joinIntoString(",") << " (default compressor)" << std::endl
+              << "  --isa <set>            fused kernel instruction set: " << HostUtil::getInstructionSetNames().joinIntoString(",") << " (default auto)" << std::endl
+              << "  --accuracy             report the error of each quality against std:: and the reference instead" << std::endl
+              << "  --automate             move speed and boostFreq before every block" << std::endl
+              << "  --sub-block <samples>  parameter ramp step, 0 applies changes per block (default 32)" << std::endl
+              << "  --param <id>=<value>   set a parameter before each case (repeatable)" << std::endl
+              << "  --state <instances>    time state save/restore over that many instances instead" << std::endl
+              << "  --memory <instances>   report heap bytes per instance instead (first rate, block and channel count)" << std::endl
+              << "  --startup <instances>  time constructing, restoring and preparing that many instances and opening" << std::endl
+              << "                         an editor with one and with all of them instead (same)" << std::endl
+              << "  --stages               print cycles per processBlock stage for each case (needs DAMNBASSBOOST_PROFILE_STAGES=1)" << std::endl
+              << "  --trace <file>         write the stages of every case as a Chrome/Perfetto trace (same)" << std::endl
+              << "  --verify               check every engine, precision and quality against the reference chain" << std::endl
+              << "  --calibrate            with --verify, print each alternative's worst difference and the tolerance" << std::endl
+              << "                         to set from it instead of failing" << std::endl
+              << "  --check-realtime       fail if processBlock allocates, locks, sleeps or does I/O (Linux)" << std::endl
+              << "  --json <file>          write results as JSON" << std::endl
+              << "  --label <text>         stored in the JSON output, e.g. a release tag" << std::endl
+              << "  --baseline <file>      compare with a previous --json run" << std::endl
+              << "  --tolerance <percent>  allowed ns/sample increase against the baseline (default 10)" << std::endl
+              << "  --quick                one second per case, 64/512/2048 blocks, 48k only" << std::endl;
+}
+
+static StringArray splitList(const String& text)
+{
+    return StringArray::fromTokens(text, ",", {});
+}
+
+template <typename Type>
+static Array<Type> parseNumbers(const String& text)
+{
+    Array<Type> numbers;
+
+    for (auto& token : splitList(text))
+        numbers.add((Type) token.getDoubleValue());
+
+    return numbers;
+}
+
+// Returns the number of cases that got slower than the baseline allows.
+static int compareWithBaseline(const Array<var>& results, const File& baselineFile, double tolerancePercent)
+{
+    auto baseline = JSON::parse(baselineFile);
+    std::map<String, double> baselineTimes;
+
+    if (auto* baselineResults = baseline["results"].getArray())
+        for (auto& entry : *baselineResults)
+            baselineTimes[entry["name"].toString()] = (double) entry["nsPerSample"];
+
+    int numRegressions = 0;
+
+    std::cout << std::endl << "Baseline: " << baselineFile.getFullPathName()
+              << " (" << baseline["label"].toString() << ")" << std::endl;
+
+    for (auto& entry : results)
+    {
+        auto name = entry["name"].toString();
+        auto found = baselineTimes.find(name);
+
+        if (found == baselineTimes.end() || found->second <= 0.0)
+            continue;
+
+        auto change = ((double) entry["nsPerSample"] / found->second - 1.0) * 100.0;
+
+        if (change > tolerancePercent)
+        {
+            std::cout << "  REGRESSION " << name << ": " << (change >= 0.0 ? "+" : "") << String(change, 1) << "%" << std::endl;
+            ++numRegressions;
+        }
+    }
+
+    std::cout << "  " << numRegressions << " regression(s) above " << String(tolerancePercent, 1) << "%" << std::endl;
+
+    return numRegressions;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI libraryInitialiser;
+
+    ProcessBenchmark::Options options;
+    StringArray engines = { "fused" };
+    StringArray signals = TestSignals::getNames();
+    Array<int> blockSizes = { 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    Array<double> sampleRates = { 44100.0, 48000.0, 96000.0, 192000.0 };
+    Array<int> channelCounts = { 1, 2 };
+    Array<int> streamCounts;
+    StringArray precisions = { "float" };
+    StringArray oversamplingFactors = { "1" };
+    File jsonFile, baselineFile, traceFile;
+    String label;
+    double tolerancePercent = 10.0;
+    int numStateInstances = 0;
+    int numMemoryInstances = 0;
+    int numStartupInstances = 0;
+    bool accuracyReport = false;
+    bool realtimeCheck = false;
+    bool verify = false;
+    bool calibrate = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        String arg(CharPointer_UTF8(argv[i]));
+        auto hasValue = i + 1 < argc;
+        auto nextValue = [&] { return String(CharPointer_UTF8(argv[++i])); };
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            return 0;
+        }
+        else if (arg == "--engines" && hasValue)     engines = splitList(nextValue());
+        else if (arg == "--signals" && hasValue)     signals = splitList(nextValue());
+        else if (arg == "--blocks" && hasValue)      blockSizes = parseNumbers<int>(nextValue());
+        else if (arg == "--rates" && hasValue)       sampleRates = parseNumbers<double>(nextValue());
+        else if (arg == "--channels" && hasValue)    channelCounts = parseNumbers<int>(nextValue());
+        else if (arg == "--streams" && hasValue)     streamCounts = parseNumbers<int>(nextValue());
+        else if (arg == "--precision" && hasValue)   precisions = splitList(nextValue());
+        else if (arg == "--oversampling" && hasValue) oversamplingFactors = splitList(nextValue());
+        else if (arg == "--seconds" && hasValue)     options.secondsPerCase = nextValue().getDoubleValue();
+        else if (arg == "--deadline" && hasValue)    options.deadline = nextValue().getDoubleValue();
+        else if (arg == "--json" && hasValue)        jsonFile = File::getCurrentWorkingDirectory().getChildFile(nextValue());
+        else if (arg == "--label" && hasValue)       label = nextValue();
+        else if (arg == "--trace" && hasValue)       traceFile = File::getCurrentWorkingDirectory().getChildFile(nextValue());
+        else if (arg == "--stages")               options.profileStages = true;
+        else if (arg == "--baseline" && hasValue)    baselineFile = File::getCurrentWorkingDirectory().getChildFile(nextValue());
+        else if (arg == "--tolerance" && hasValue)   tolerancePercent = nextValue().getDoubleValue();
+        else if (arg == "--sub-block" && hasValue)   options.settings.subBlockSize = jmax(0, nextValue().getIntValue());
+        else if (arg == "--state" && hasValue)       numStateInstances = jmax(1, nextValue().getIntValue());
+        else if (arg == "--memory" && hasValue)      numMemoryInstances = jmax(1, nextValue().getIntValue());
+        else if (arg == "--startup" && hasValue)     numStartupInstances = jmax(1, nextValue().getIntValue());
+        else if (arg == "--coefficient-tables")   options.settings.coefficientTables = true;
+        else if (arg == "--accuracy")             accuracyReport = true;
+        else if (arg == "--check-realtime")       realtimeCheck = true;
+        else if (arg == "--verify")               verify = true;
+        else if (arg == "--calibrate")            calibrate = true;
+        else if (arg == "--quality" && hasValue)
+        {
+            if (! HostUtil::parseQuality(nextValue(), options.settings.quality))
+            {
+                std::cerr << "Expected --quality " << HostUtil::getQualityNames().joinIntoString("|") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--isa" && hasValue)
+        {
+            if (! HostUtil::parseInstructionSet(nextValue(), options.settings.instructionSet))
+            {
+                std::cerr << "Expected --isa " << HostUtil::getInstructionSetNames().joinIntoString("|") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--detector" && hasValue)
+        {
+            if (! HostUtil::parseDetector(nextValue(), options.settings.detector))
+            {
+                std::cerr << "Expected --detector " << HostUtil::getDetectorNames().joinIntoString("|") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--blend" && hasValue)
+        {
+            if (! HostUtil::parseBlendMode(nextValue(), options.settings.blendMode))
+            {
+                std::cerr << "Expected --blend " << HostUtil::getBlendModeNames().joinIntoString("|") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--automate")             options.automate = true;
+        else if (arg == "--quick")
+        {
+            options.secondsPerCase = 1.0;
+            blockSizes = { 64, 512, 2048 };
+            sampleRates = { 48000.0 };
+        }
+        else if (arg == "--param" && hasValue)
+        {
+            HostUtil::ParameterSetting setting;
+
+            if (! HostUtil::parseParameterSetting(nextValue(), setting))
+            {
+                std::cerr << "Expected --param <id>=<value>" << std::endl;
+                return 1;
+            }
+
+            options.settings.parameters.add(setting);
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (numStateInstances > 0)
+    {
+        std::cout << SystemStats::getCpuModel() << ", " << numStateInstances << " instances" << std::endl
+                  << std::endl
+                  << String("format").paddedRight(' ', 10)
+                  << String("save us").paddedLeft(' ', 10)
+                  << String("restore us").paddedLeft(' ', 12)
+                  << String("bytes").paddedLeft(' ', 8) << std::endl;
+
+        for (auto format : { StateBenchmark::Format::binary, StateBenchmark::Format::xml })
+        {
+            auto result = StateBenchmark::run(format, numStateInstances, 10);
+
+            std::cout << StateBenchmark::getFormatName(format).paddedRight(' ', 10)
+                      << String(result.saveUs, 2).paddedLeft(' ', 10)
+                      << String(result.restoreUs, 2).paddedLeft(' ', 12)
+                      << String((int) result.bytes).paddedLeft(' ', 8) << std::endl;
+        }
+
+        return 0;
+    }
+
+    if (traceFile != File())
+        options.profileStages = true;
+
+   #if ! DAMNBASSBOOST_PROFILE_STAGES
+    if (options.profileStages)
+    {
+        std::cerr << "--stages and --trace need a build with DAMNBASSBOOST_PROFILE_STAGES=1" << std::endl;
+        return 1;
+    }
+   #endif
+
+    if (realtimeCheck)
+        return RealtimeCheck::run(std::cout, {}) == 0 ? 0 : 1;
+
+    if (verify)
+    {
+        auto sampleRate = sampleRates.isEmpty() ? 48000.0 : sampleRates.getFirst();
+        auto blockSize = blockSizes.isEmpty() ? 512 : blockSizes.getFirst();
+        return EquivalenceCheck::run(std::cout, sampleRate, jmax(blockSize, 64), calibrate) == 0 ? 0 : 1;
+    }
+
+    if (accuracyReport)
+    {
+        AccuracyReport::print(std::cout, sampleRates.isEmpty() ? 48000.0 : sampleRates.getFirst());
+        return 0;
+    }
+
+    if (numMemoryInstances > 0)
+    {
+        auto sampleRate = sampleRates.isEmpty() ? 48000.0 : sampleRates.getFirst();
+        auto blockSize = blockSizes.isEmpty() ? 512 : blockSizes.getFirst();
+        auto numChannels = channelCounts.isEmpty() ? 2 : channelCounts.getFirst();
+
+        if (engines.size() == 1)
+            HostUtil::parseEngine(engines[0], options.settings.engine);
+
+        auto result = MemoryBenchmark::run(numMemoryInstances, sampleRate, blockSize, numChannels, options.settings);
+
+        if (result.error.isNotEmpty())
+        {
+            std::cerr << result.error << std::endl;
+            return 1;
+        }
+
+        std::cout << numMemoryInstances << " instances, " << HostUtil::getEngineName(options.settings.engine) << ", "
+                  << String(sampleRate / 1000.0, 1) << "k " << blockSize << ", " << numChannels << " channels" << std::endl
+                  << std::endl
+                  << "sizeof(PluginAudioProcessor)  " << (int) result.objectBytes << std::endl
+                  << "heap bytes per instance:" << std::endl
+                  << "  constructed                 " << String(result.constructed, 0) << std::endl
+                  << "  prepared                    +" << String(result.prepared, 0) << std::endl
+                  << "  editor open                 +" << String(result.editor, 0) << std::endl
+                  << "  total                       " << String(result.constructed + result.prepared + result.editor, 0) << std::endl
+                  << "  program crossfade           +" << String(result.crossfade, 0) << " (after a program change)" << std::endl;
+
+        return 0;
+    }
+
+    if (numStartupInstances > 0)
+    {
+        auto sampleRate = sampleRates.isEmpty() ? 48000.0 : sampleRates.getFirst();
+        auto blockSize = blockSizes.isEmpty() ? 512 : blockSizes.getFirst();
+        auto numChannels = channelCounts.isEmpty() ? 2 : channelCounts.getFirst();
+
+        if (engines.size() == 1)
+            HostUtil::parseEngine(engines[0], options.settings.engine);
+
+        auto result = StartupBenchmark::run(numStartupInstances, sampleRate, blockSize, numChannels, options.settings);
+
+        if (result.error.isNotEmpty())
+        {
+            std::cerr << result.error << std::endl;
+            return 1;
+        }
+
+        auto sessionMs = numStartupInstances * (result.constructUs + result.restoreUs + result.prepareUs) / 1000.0;
+
+        std::cout << numStartupInstances << " instances, " << HostUtil::getEngineName(options.settings.engine) << ", "
+                  << String(sampleRate / 1000.0, 1) << "k " << blockSize << ", " << numChannels << " channels" << std::endl
+                  << std::endl
+                  << "us per instance:" << std::endl
+                  << "  construct                   " << String(result.constructUs, 1) << std::endl
+                  << "  restore state               " << String(result.restoreUs, 1) << std::endl
+                  << "  prepare                     " << String(result.prepareUs, 1) << std::endl
+                  << "session recall               " << String(sessionMs, 1) << " ms" << std::endl
+                  << std::endl
+                  << "editor open and first paint, us:" << std::endl
+                  << "  first in process            " << String(result.firstEditorUs, 1) << std::endl
+                  << "  with 1 instance             " << String(result.editorUs, 1) << std::endl
+                  << "  with " << String(numStartupInstances).paddedRight(' ', 5) << " instances     " << String(result.editorAtScaleUs, 1) << std::endl;
+
+        auto printPaints = [](const String& title, const PaintProfiler& paints)
+        {
+            std::cout << std::endl << title << ":" << std::endl;
+
+            for (auto& line : StringArray::fromLines(paints.getSummary().trimEnd()))
+                std::cout << "  " << line << std::endl;
+        };
+
+        printPaints("first paint, first in process", result.firstEditorPaints);
+        printPaints("first paint, with 1 instance", result.editorPaints);
+        printPaints("first paint, with " + String(numStartupInstances) + " instances", result.editorAtScalePaints);
+
+        return 0;
+    }
+
+    Array<PluginAudioProcessor::Engine> engineTypes;
+
+    for (auto& name : engines)
+    {
+        PluginAudioProcessor::Engine engine;
+
+        if (! HostUtil::parseEngine(name, engine))
+        {
+            std::cerr << "Unknown engine " << name << std::endl;
+            return 1;
+        }
+
+        engineTypes.add(engine);
+    }
+
+    for (auto& precision : precisions)
+    {
+        if (precision != "float" && precision != "double")
+        {
+            std::cerr << "Unknown precision " << precision << std::endl;
+            return 1;
+        }
+    }
+
+    Array<BassBoostOversampling> oversamplings;
+
+    for (auto& factor : oversamplingFactors)
+    {
+        BassBoostOversampling oversampling;
+
+        if (! HostUtil::parseOversampling(factor, oversampling))
+        {
+            std::cerr << "Unknown oversampling " << factor << std::endl;
+            return 1;
+        }
+
+        oversamplings.add(oversampling);
+    }
+
+    for (auto& signal : signals)
+    {
+        if (! TestSignals::getNames().contains(signal))
+        {
+            std::cerr << "Unknown signal " << signal << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << SystemStats::getCpuModel() << ", " << SystemStats::getNumCpus() << " cores, fused kernel "
+              << BassBoostDispatch::getName(BassBoostDispatch::resolve(options.settings.instructionSet)) << std::endl
+              << std::endl
+              << String("case").paddedRight(' ', 42)
+              << String("ns/sample").paddedLeft(' ', 11)
+              << String("p50 us").paddedLeft(' ', 10)
+              << String("p99 us").paddedLeft(' ', 10)
+              << String("max us").paddedLeft(' ', 10)
+              << String("inst/core").paddedLeft(' ', 11) << std::endl;
+
+    Array<ProcessBenchmark::Case> cases;
+
+    for (auto& signal : signals)
+    {
+        for (auto numChannels : channelCounts)
+            for (auto sampleRate : sampleRates)
+                for (auto blockSize : blockSizes)
+                    for (auto engine : engineTypes)
+                        for (auto& precision : precisions)
+                            for (auto oversampling : oversamplings)
+                                cases.add({ engine, signal, sampleRate, blockSize, numChannels, false, precision == "double", oversampling });
+
+       #if JUCE_USE_SIMD
+        for (auto numStreams : streamCounts)
+            for (auto sampleRate : sampleRates)
+                for (auto blockSize : blockSizes)
+                    cases.add({ PluginAudioProcessor::Engine::fused, signal, sampleRate, blockSize, numStreams, true });
+       #endif
+    }
+
+    Array<var> results;
+
+    // ns/sample of every case, for the oversampling overhead
+    std::map<String, double> caseTimes;
+
+   #if DAMNBASSBOOST_PROFILE_STAGES
+    std::vector<StageProfiler::Track> traceTracks;
+    double cyclesPerMicrosecond = 1.0;
+   #endif
+
+    for (auto& benchmarkCase : cases)
+    {
+        auto result = ProcessBenchmark::run(benchmarkCase, options);
+        results.add(result.toVar());
+
+       #if DAMNBASSBOOST_PROFILE_STAGES
+        if (result.stageSummary.isNotEmpty())
+        {
+            traceTracks.push_back({ benchmarkCase.getName(), std::move(result.stageEvents) });
+            cyclesPerMicrosecond = result.cyclesPerMicrosecond;
+        }
+       #endif
+
+        std::cout << result.benchmarkCase.getName().paddedRight(' ', 42);
+
+        if (result.error.isNotEmpty())
+        {
+            std::cout << "  " << result.error << std::endl;
+            continue;
+        }
+
+        caseTimes[benchmarkCase.getName()] = result.nsPerSample;
+
+        std::cout << String(result.nsPerSample, 2).paddedLeft(' ', 11)
+                  << String(result.p50Us, 1).paddedLeft(' ', 10)
+                  << String(result.p99Us, 1).paddedLeft(' ', 10)
+                  << String(result.maxUs, 1).paddedLeft(' ', 10)
+                  << String((int) result.instancesPerCore).paddedLeft(' ', 11) << std::endl;
+
+       #if DAMNBASSBOOST_PROFILE_STAGES
+        if (result.stageSummary.isNotEmpty())
+            std::cout << std::endl << result.stageSummary << std::endl;
+       #endif
+    }
+
+    // What oversampling the ladder adds to the whole processBlock, per factor.
+    if (oversamplings.size() > 1 || oversamplings.getFirst() != BassBoostOversampling::x1)
+    {
+        std::cout << std::endl << "Ladder oversampling overhead against 1x:" << std::endl;
+
+        for (int i = 0; i < cases.size(); ++i)
+        {
+            auto& benchmarkCase = cases.getReference(i);
+
+            if (benchmarkCase.oversampling == BassBoostOversampling::x1)
+                continue;
+
+            auto time = caseTimes.find(benchmarkCase.getName());
+            auto reference = caseTimes.find(benchmarkCase.withoutOversampling().getName());
+
+            if (time == caseTimes.end() || reference == caseTimes.end() || reference->second <= 0.0)
+                continue;
+
+            auto overhead = (time->second / reference->second - 1.0) * 100.0;
+
+            if (auto* entry = results.getReference(i).getDynamicObject())
+                entry->setProperty("oversamplingOverheadPercent", overhead);
+
+            std::cout << benchmarkCase.getName().paddedRight(' ', 42)
+                      << String(time->second - reference->second, 2).paddedLeft(' ', 11) << " ns/sample"
+                      << ((overhead >= 0.0 ? "+" : "") + String(overhead, 1) + "%").paddedLeft(' ', 10) << std::endl;
+        }
+    }
+
+   #if DAMNBASSBOOST_PROFILE_STAGES
+    if (traceFile != File())
+    {
+        traceFile.deleteFile();
+        FileOutputStream out(traceFile);
+
+        if (! out.openedOk())
+        {
+            std::cerr << "Cannot write " << traceFile.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        StageProfiler::writeChromeTrace(out, traceTracks, cyclesPerMicrosecond);
+    }
+   #endif
+
+    if (jsonFile != File())
+    {
+        auto* root = new DynamicObject();
+        root->setProperty("label", label);
+        root->setProperty("date", Time::getCurrentTime().toISO8601(true));
+        root->setProperty("cpu", SystemStats::getCpuModel());
+        root->setProperty("numCpus", SystemStats::getNumCpus());
+        root->setProperty("os", SystemStats::getOperatingSystemName());
+        root->setProperty("secondsPerCase", options.secondsPerCase);
+        root->setProperty("deadline", options.deadline);
+        root->setProperty("automate", options.automate);
+        root->setProperty("coefficientTables", options.settings.coefficientTables);
+        root->setProperty("blend", HostUtil::getBlendModeName(options.settings.blendMode));
+        root->setProperty("quality", HostUtil::getQualityName(options.settings.quality));
+        root->setProperty("detector", HostUtil::getDetectorName(options.settings.detector));
+        root->setProperty("isa", BassBoostDispatch::getName(BassBoostDispatch::resolve(options.settings.instructionSet)));
+        root->setProperty("subBlockSize", options.settings.subBlockSize);
+        root->setProperty("results", results);
+
+        if (! jsonFile.replaceWithText(JSON::toString(var(root))))
+        {
+            std::cerr << "Cannot write " << jsonFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    if (baselineFile.existsAsFile())
+        return compareWithBaseline(results, baselineFile, tolerancePercent) == 0 ? 0 : 2;
+
+    return 0;
+}
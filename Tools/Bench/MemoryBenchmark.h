@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../Common/HostUtil.h"
+
+#if JUCE_LINUX
+ #include <malloc.h>
+#elif JUCE_MAC
+ #include <malloc/malloc.h>
+#elif JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+//==============================================================================
+// Heap bytes per processor instance, measured as the growth of the process heap
+// while many instances are created, prepared, given an editor and prepared
+// again after a program change (the fused engine's program crossfade), divided
+// by the number of instances. Shared resources (coefficient tables, the look and
+// feel, the typeface) are paid once and vanish from the average as the count
+// grows.
+namespace MemoryBenchmark
+{
+    struct Result
+    {
+        int numInstances = 0;
+        size_t objectBytes = 0;   // sizeof(PluginAudioProcessor)
+        double constructed = 0.0; // per instance
+        double prepared = 0.0;    // per instance, on top of constructed
+        double editor = 0.0;      // per instance, on top of prepared
+        double crossfade = 0.0;   // per instance, on top of editor: a program change and another prepare
+        String error;
+    };
+
+    // Bytes currently allocated from the C heap, or -1 where not supported.
+    inline int64 getHeapBytesInUse()
+    {
+       #if JUCE_LINUX && defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+        return (int64) mallinfo2().uordblks;
+       #elif JUCE_LINUX && defined(__GLIBC__)
+        return (int64) (unsigned int) mallinfo().uordblks;
+       #elif JUCE_MAC
+        malloc_statistics_t statistics;
+        malloc_zone_statistics(nullptr, &statistics);
+        return (int64) statistics.size_in_use;
+       #elif JUCE_WINDOWS
+        int64 total = 0;
+        _HEAPINFO entry {};
+
+        while (_heapwalk(&entry) == _HEAPOK)
+            if (entry._useflag == _USEDENTRY)
+                total += (int64) entry._size;
+
+        return total;
+       #else
+        return -1;
+       #endif
+    }
+
+    inline Result run(int numInstances, double sampleRate, int blockSize, int numChannels,
+                      const HostUtil::ProcessorSettings& settings)
+    {
+        Result result;
+        result.numInstances = numInstances;
+        result.objectBytes = sizeof(PluginAudioProcessor);
+
+        if (getHeapBytesInUse() < 0)
+        {
+            result.error = "heap statistics are not available on this platform";
+            return result;
+        }
+
+        OwnedArray<PluginAudioProcessor> processors;
+        OwnedArray<AudioProcessorEditor> editors;
+        processors.ensureStorageAllocated(numInstances);
+        editors.ensureStorageAllocated(numInstances);
+
+        auto perInstance = [numInstances](int64 from, int64 to) { return (double) (to - from) / numInstances; };
+
+        auto start = getHeapBytesInUse();
+
+        for (int i = 0; i < numInstances; ++i)
+            processors.add(new PluginAudioProcessor());
+
+        auto constructed = getHeapBytesInUse();
+
+        for (auto* processor : processors)
+        {
+            result.error = HostUtil::applySettings(*processor, settings);
+
+            if (result.error.isNotEmpty())
+                return result;
+
+            if (! HostUtil::setChannelLayout(*processor, numChannels))
+            {
+                result.error = "Unsupported channel count";
+                return result;
+            }
+
+            processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+            processor->prepareToPlay(sampleRate, blockSize);
+        }
+
+        auto prepared = getHeapBytesInUse();
+
+        for (auto* processor : processors)
+            editors.add(processor->createEditor());
+
+        auto withEditors = getHeapBytesInUse();
+
+        for (auto* processor : processors)
+        {
+            processor->setCurrentProgram(processor->getCurrentProgram());
+            processor->prepareToPlay(sampleRate, blockSize);
+        }
+
+        auto withCrossfade = getHeapBytesInUse();
+
+        result.constructed = perInstance(start, constructed);
+        result.prepared = perInstance(constructed, prepared);
+        result.editor = perInstance(prepared, withEditors);
+        result.crossfade = perInstance(withEditors, withCrossfade);
+
+        editors.clear();
+        return result;
+    }
+}
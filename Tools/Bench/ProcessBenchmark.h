@@ -0,0 +1,313 @@
+#pragma once
+
+#include "../Common/HostUtil.h"
+#include "../../Source/MultiStreamBassBoost.h"
+#include "TestSignals.h"
+
+#include <chrono>
+#include <numeric>
+
+//==============================================================================
+// Times PluginAudioProcessor::processBlock for one combination of signal,
+// sample rate, block size and channel count, or MultiStreamBassBoost::process
+// for that many independent streams.
+namespace ProcessBenchmark
+{
+    struct Case
+    {
+        PluginAudioProcessor::Engine engine = PluginAudioProcessor::Engine::fused;
+        String signal;
+        double sampleRate = 44100.0;
+        int blockSize = 512;
+        int numChannels = 2;
+        bool multiStream = false; // numChannels streams through one MultiStreamBassBoost
+        bool doublePrecision = false;
+        BassBoostOversampling oversampling = BassBoostOversampling::x1; // of the ladder filter
+
+        String getName() const
+        {
+            return (multiStream ? String("multistream") : HostUtil::getEngineName(engine)) + " " + signal + " " + String(sampleRate / 1000.0, 1) + "k " + String(blockSize)
+                 + (numChannels == 1 ? " mono" : numChannels == 2 ? " stereo" : " " + String(numChannels) + "ch")
+                 + (doublePrecision ? " double" : "")
+                 + (oversampling != BassBoostOversampling::x1 ? " os" + HostUtil::getOversamplingName(oversampling) + "x" : String());
+        }
+
+        // The same case without oversampling, whose time the overhead is measured against.
+        Case withoutOversampling() const
+        {
+            auto other = *this;
+            other.oversampling = BassBoostOversampling::x1;
+            return other;
+        }
+    };
+
+    struct Options
+    {
+        double secondsPerCase = 2.0;
+        double warmUpSeconds = 0.25;
+        double deadline = 1.0; // fraction of the block period one core may spend
+        bool automate = false; // move speed and boostFreq before every block
+        bool profileStages = false; // keep the stage summary and trace events, see StageProfiler
+        HostUtil::ProcessorSettings settings;
+    };
+
+    struct Result
+    {
+        Case benchmarkCase;
+        double nsPerSample = 0.0; // per sample frame, all channels
+        double p50Us = 0.0;
+        double p99Us = 0.0;
+        double maxUs = 0.0;
+        double blockPeriodUs = 0.0;
+        double instancesPerCore = 0.0;
+        BassBoostInstructionSet instructionSet = BassBoostInstructionSet::baseline;
+        String error;
+
+       #if DAMNBASSBOOST_PROFILE_STAGES
+        String stageSummary;
+        std::vector<StageProfiler::Event> stageEvents; // the first 8192, warm-up included, see PluginAudioProcessor::stageProfiler
+        double cyclesPerMicrosecond = 1.0;
+       #endif
+
+        var toVar() const
+        {
+            auto* object = new DynamicObject();
+            object->setProperty("name", benchmarkCase.getName());
+            object->setProperty("engine", benchmarkCase.multiStream ? String("multistream") : HostUtil::getEngineName(benchmarkCase.engine));
+            object->setProperty("signal", benchmarkCase.signal);
+            object->setProperty("sampleRate", benchmarkCase.sampleRate);
+            object->setProperty("blockSize", benchmarkCase.blockSize);
+            object->setProperty("numChannels", benchmarkCase.numChannels);
+            object->setProperty("precision", benchmarkCase.doublePrecision ? "double" : "float");
+            object->setProperty("oversampling", HostUtil::getOversamplingName(benchmarkCase.oversampling).getIntValue());
+            object->setProperty("nsPerSample", nsPerSample);
+            object->setProperty("p50Us", p50Us);
+            object->setProperty("p99Us", p99Us);
+            object->setProperty("maxUs", maxUs);
+            object->setProperty("blockPeriodUs", blockPeriodUs);
+            object->setProperty("instancesPerCore", instancesPerCore);
+            object->setProperty("isa", BassBoostDispatch::getName(instructionSet));
+
+            if (error.isNotEmpty())
+                object->setProperty("error", error);
+
+            return var(object);
+        }
+    };
+
+    inline double getPercentile(const std::vector<double>& sorted, double percentile)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        auto index = (size_t) roundToInt(percentile * (double) (sorted.size() - 1));
+        return sorted[index];
+    }
+
+    // Runs warm-up blocks, then times numBlocks calls of process(), each
+    // preceded by an untimed call of nextBlock().
+    template <typename NextBlock, typename Process>
+    void timeBlocks(Result& result, const Options& options, NextBlock&& nextBlock, Process&& process)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        auto sampleRate = result.benchmarkCase.sampleRate;
+        auto blockSize = result.benchmarkCase.blockSize;
+
+        auto numWarmUpBlocks = jmax(1, (int) (options.warmUpSeconds * sampleRate / blockSize));
+        auto numBlocks = jmax(16, (int) (options.secondsPerCase * sampleRate / blockSize));
+
+        for (int i = 0; i < numWarmUpBlocks; ++i)
+        {
+            nextBlock();
+            process();
+        }
+
+        std::vector<double> blockTimes;
+        blockTimes.reserve((size_t) numBlocks);
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            nextBlock();
+
+            auto start = Clock::now();
+            process();
+            auto end = Clock::now();
+
+            blockTimes.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+
+        auto totalNs = std::accumulate(blockTimes.begin(), blockTimes.end(), 0.0);
+        std::sort(blockTimes.begin(), blockTimes.end());
+
+        result.nsPerSample = totalNs / ((double) numBlocks * blockSize);
+        result.p50Us = getPercentile(blockTimes, 0.5) / 1000.0;
+        result.p99Us = getPercentile(blockTimes, 0.99) / 1000.0;
+        result.maxUs = blockTimes.back() / 1000.0;
+        result.blockPeriodUs = blockSize * 1.0e6 / sampleRate;
+        result.instancesPerCore = result.p99Us > 0.0 ? std::floor(options.deadline * result.blockPeriodUs / result.p99Us) : 0.0;
+    }
+
+   #if JUCE_USE_SIMD
+    // Every stream gets the same settings, as N plugin instances of one preset would.
+    inline Result runMultiStream(const Case& benchmarkCase, const Options& options)
+    {
+        Result result;
+        result.benchmarkCase = benchmarkCase;
+
+        auto sampleRate = benchmarkCase.sampleRate;
+        auto blockSize = benchmarkCase.blockSize;
+        auto numStreams = benchmarkCase.numChannels;
+
+        // The processor is only used to resolve --param and --state into parameter values.
+        PluginAudioProcessor processor;
+        result.error = HostUtil::applySettings(processor, options.settings);
+
+        if (result.error.isNotEmpty())
+            return result;
+
+        auto parameters = HostUtil::getBassBoostParameters(processor);
+        auto* speedParameter = HostUtil::findParameter(processor, "speed");
+        auto* boostFreqParameter = HostUtil::findParameter(processor, "boostFreq");
+
+        MultiStreamBassBoost engine;
+        engine.setQuality(options.settings.quality);
+        engine.setInstructionSet(options.settings.instructionSet);
+        engine.prepare(sampleRate, blockSize, numStreams);
+        result.instructionSet = engine.getInstructionSet();
+
+        AudioBuffer<float> source(numStreams, (int) (sampleRate * 4.0));
+        TestSignals::fill(benchmarkCase.signal, source, sampleRate);
+
+        AudioBuffer<float> buffer(numStreams, blockSize);
+        int sourcePosition = 0;
+        int blockIndex = 0;
+        auto automated = parameters;
+
+        auto nextBlock = [&]
+        {
+            if (sourcePosition + blockSize > source.getNumSamples())
+                sourcePosition = 0;
+
+            for (int ch = 0; ch < numStreams; ++ch)
+                buffer.copyFrom(ch, 0, source, ch, sourcePosition, blockSize);
+
+            sourcePosition += blockSize;
+
+            if (options.automate)
+            {
+                auto position = (float) (blockIndex++ % 1000) / 1000.0f;
+                automated.speed = speedParameter->convertFrom0to1(position);
+                automated.boostFreq = boostFreqParameter->convertFrom0to1(1.0f - position);
+            }
+        };
+
+        // Parameter updates are timed, as they are inside processBlock.
+        auto process = [&]
+        {
+            for (int stream = 0; stream < numStreams; ++stream)
+                engine.setParameters(stream, automated);
+
+            engine.process(dsp::AudioBlock<float>(buffer));
+        };
+
+        timeBlocks(result, options, nextBlock, process);
+
+        return result;
+    }
+   #endif
+
+    // Drives processBlock with AudioBuffer<SampleType>, the way a host running at that precision would.
+    template <typename SampleType>
+    Result runProcessor(const Case& benchmarkCase, const Options& options)
+    {
+        Result result;
+        result.benchmarkCase = benchmarkCase;
+
+        auto sampleRate = benchmarkCase.sampleRate;
+        auto blockSize = benchmarkCase.blockSize;
+        auto numChannels = benchmarkCase.numChannels;
+
+        auto settings = options.settings;
+        settings.engine = benchmarkCase.engine;
+        settings.oversampling = benchmarkCase.oversampling;
+
+        PluginAudioProcessor processor;
+        result.error = HostUtil::applySettings(processor, settings);
+
+        if (result.error.isNotEmpty())
+            return result;
+
+        if (! HostUtil::setChannelLayout(processor, numChannels))
+        {
+            result.error = "unsupported layout";
+            return result;
+        }
+
+        // A few seconds of source material, looped and copied in block by block outside the timed region.
+        AudioBuffer<float> signal(numChannels, (int) (sampleRate * 4.0));
+        TestSignals::fill(benchmarkCase.signal, signal, sampleRate);
+
+        AudioBuffer<SampleType> source;
+        source.makeCopyOf(signal);
+
+        AudioBuffer<SampleType> buffer(numChannels, blockSize);
+        MidiBuffer midi;
+        int sourcePosition = 0;
+
+        auto* speedParameter = HostUtil::findParameter(processor, "speed");
+        auto* boostFreqParameter = HostUtil::findParameter(processor, "boostFreq");
+        int blockIndex = 0;
+
+        auto nextBlock = [&]
+        {
+            if (sourcePosition + blockSize > source.getNumSamples())
+                sourcePosition = 0;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                buffer.copyFrom(ch, 0, source, ch, sourcePosition, blockSize);
+
+            sourcePosition += blockSize;
+
+            if (options.automate)
+            {
+                auto position = (float) (blockIndex++ % 1000) / 1000.0f;
+                speedParameter->setValueNotifyingHost(position);
+                boostFreqParameter->setValueNotifyingHost(1.0f - position);
+            }
+        };
+
+        processor.setProcessingPrecision(std::is_same<SampleType, double>::value ? AudioProcessor::doublePrecision
+                                                                                 : AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+        result.instructionSet = processor.getActiveInstructionSet();
+
+        timeBlocks(result, options, nextBlock, [&] { processor.processBlock(buffer, midi); });
+
+       #if DAMNBASSBOOST_PROFILE_STAGES
+        if (options.profileStages)
+        {
+            auto& profiler = processor.getStageProfiler();
+            result.stageSummary = profiler.getSummary();
+            result.cyclesPerMicrosecond = profiler.getCyclesPerMicrosecond();
+            profiler.readEvents(result.stageEvents);
+        }
+       #endif
+
+        processor.releaseResources();
+
+        return result;
+    }
+
+    inline Result run(const Case& benchmarkCase, const Options& options)
+    {
+       #if JUCE_USE_SIMD
+        if (benchmarkCase.multiStream)
+            return runMultiStream(benchmarkCase, options);
+       #endif
+
+        return benchmarkCase.doublePrecision ? runProcessor<double>(benchmarkCase, options)
+                                             : runProcessor<float>(benchmarkCase, options);
+    }
+}
@@ -0,0 +1,580 @@
+#pragma once
+
+#include "../Common/HostUtil.h"
+#include "TestSignals.h"
+
+#include <cerrno>
+#include <thread>
+
+// The C library calls are replaced in the executable and counted while the
+// calling thread is inside a RealtimeCheck::ScopedMonitor. This needs glibc,
+// which exports the allocator under __libc_* names to forward to. Include this
+// header from one translation unit only, as it defines the replacements.
+#if JUCE_LINUX && defined(__GLIBC__)
+ #define DAMNBASSBOOST_REALTIME_CHECK 1
+ #include <dlfcn.h>
+ #include <execinfo.h>
+ #include <pthread.h>
+ #include <time.h>
+ #include <unistd.h>
+#else
+ #define DAMNBASSBOOST_REALTIME_CHECK 0
+#endif
+
+//==============================================================================
+// Drives PluginAudioProcessor the way a host does and fails if its audio
+// thread work allocates or frees memory, takes a lock, sleeps or does file
+// I/O. Covered: processBlock after prepare and after layout and sample rate
+// changes, with every engine and precision, with a meter reader attached,
+// with shorter blocks than prepared, through silence, with parameters moved
+// from the audio thread as host automation does, and while another thread
+// changes programs or restores the state.
+namespace RealtimeCheck
+{
+    enum Violation
+    {
+        allocation,
+        deallocation,
+        lock,
+        sleep,
+        fileIo,
+        numViolations,
+    };
+
+    inline const char* getViolationName(Violation violation)
+    {
+        static const char* const names[] = { "allocation", "deallocation", "lock", "sleep", "file I/O" };
+        return names[(size_t) violation];
+    }
+
+   #if DAMNBASSBOOST_REALTIME_CHECK
+    namespace detail
+    {
+        static constexpr int maxStackDepth = 32;
+
+        struct Record
+        {
+            std::atomic<int64> count { 0 };
+            std::atomic<bool> hasStack { false };
+            void* stack[maxStackDepth] {};
+            int stackDepth = 0;
+        };
+
+        inline Record records[numViolations];
+        inline thread_local bool monitoring = false;
+        inline thread_local bool reporting = false;
+
+        // Called from the replacements; must not allocate or lock itself.
+        inline void report(Violation violation) noexcept
+        {
+            if (! monitoring || reporting)
+                return;
+
+            reporting = true;
+            auto& record = records[(size_t) violation];
+            record.count.fetch_add(1, std::memory_order_relaxed);
+
+            if (! record.hasStack.exchange(true))
+                record.stackDepth = backtrace(record.stack, maxStackDepth);
+
+            reporting = false;
+        }
+
+        template <typename Function>
+        Function findNext(std::atomic<Function>& next, const char* name) noexcept
+        {
+            auto function = next.load(std::memory_order_acquire);
+
+            if (function == nullptr)
+            {
+                function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+                next.store(function, std::memory_order_release);
+            }
+
+            return function;
+        }
+    }
+
+    // Counts violations on the calling thread while it exists.
+    struct ScopedMonitor
+    {
+        ScopedMonitor() noexcept  { detail::monitoring = true; }
+        ~ScopedMonitor()          { detail::monitoring = false; }
+    };
+
+    inline int64 getNumViolations(Violation violation) noexcept
+    {
+        return detail::records[(size_t) violation].count.load(std::memory_order_relaxed);
+    }
+
+    inline void clearViolations() noexcept
+    {
+        for (auto& record : detail::records)
+        {
+            record.count = 0;
+            record.hasStack = false;
+        }
+    }
+
+    // backtrace() loads libgcc on its first call, which allocates.
+    inline void warmUp()
+    {
+        void* stack[4];
+        backtrace(stack, 4);
+    }
+
+    inline void printStack(Violation violation)
+    {
+        auto& record = detail::records[(size_t) violation];
+
+        if (record.hasStack && record.stackDepth > 0)
+            backtrace_symbols_fd(record.stack, record.stackDepth, STDERR_FILENO);
+    }
+   #endif
+
+    //==============================================================================
+    struct Options
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int numBlocks = 400; // per phase
+        bool printStacks = true;
+    };
+
+   #if DAMNBASSBOOST_REALTIME_CHECK
+    namespace detail
+    {
+        struct Configuration
+        {
+            String name;
+            HostUtil::ProcessorSettings settings;
+            bool doublePrecision = false;
+        };
+
+        template <typename SampleType>
+        class Driver
+        {
+        public:
+            explicit Driver(PluginAudioProcessor& p) : processor(p) {}
+
+            // Not monitored: what a host does before starting the audio thread.
+            bool prepare(int numChannels, double sampleRate, int blockSize)
+            {
+                processor.releaseResources();
+
+                if (! HostUtil::setChannelLayout(processor, numChannels))
+                    return false;
+
+                processor.setProcessingPrecision(std::is_same<SampleType, double>::value ? AudioProcessor::doublePrecision
+                                                                                         : AudioProcessor::singlePrecision);
+                processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+                processor.prepareToPlay(sampleRate, blockSize);
+
+                AudioBuffer<float> signal(numChannels, (int) sampleRate);
+                TestSignals::fill("program", signal, sampleRate);
+                source.makeCopyOf(signal);
+                buffer.setSize(numChannels, blockSize);
+                maximumBlockSize = blockSize;
+                sourcePosition = 0;
+                return true;
+            }
+
+            // Blocks of the prepared size, or of random sizes up to it; silent
+            // blocks are zeros. The host-side copying is not monitored.
+            void process(int numBlocks, bool randomSizes, bool silent, const std::function<void()>& beforeBlock = {})
+            {
+                for (int i = 0; i < numBlocks; ++i)
+                {
+                    const auto numSamples = randomSizes ? random.nextInt({ 1, maximumBlockSize + 1 }) : maximumBlockSize;
+
+                    if (sourcePosition + numSamples > source.getNumSamples())
+                        sourcePosition = 0;
+
+                    AudioBuffer<SampleType> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+
+                    if (silent)
+                        block.clear();
+                    else
+                        for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                            block.copyFrom(ch, 0, source, ch, sourcePosition, numSamples);
+
+                    sourcePosition += numSamples;
+
+                    const ScopedMonitor monitor;
+
+                    if (beforeBlock)
+                        beforeBlock();
+
+                    processor.processBlock(block, midi);
+                }
+            }
+
+        private:
+            PluginAudioProcessor& processor;
+            AudioBuffer<SampleType> source, buffer;
+            MidiBuffer midi;
+            Random random { 0x5eed };
+            int maximumBlockSize = 0;
+            int sourcePosition = 0;
+        };
+
+        inline bool reportCheck(std::ostream& out, const String& name, const Options& options)
+        {
+            StringArray found;
+
+            for (int i = 0; i < numViolations; ++i)
+                if (auto count = getNumViolations((Violation) i))
+                    found.add(String(count) + " " + getViolationName((Violation) i));
+
+            out << (found.isEmpty() ? "ok    " : "FAIL  ") << name;
+
+            if (! found.isEmpty())
+                out << ": " << found.joinIntoString(", ");
+
+            out << std::endl;
+
+            if (! found.isEmpty() && options.printStacks)
+            {
+                for (int i = 0; i < numViolations; ++i)
+                {
+                    if (getNumViolations((Violation) i) > 0)
+                    {
+                        out << "  first " << getViolationName((Violation) i) << ":" << std::endl;
+                        out.flush();
+                        printStack((Violation) i);
+                    }
+                }
+            }
+
+            clearViolations();
+            return found.isEmpty();
+        }
+
+        template <typename SampleType>
+        int runConfiguration(std::ostream& out, const Configuration& configuration, const Options& options)
+        {
+            int numFailed = 0;
+
+            PluginAudioProcessor processor;
+            auto error = HostUtil::applySettings(processor, configuration.settings);
+
+            if (error.isNotEmpty())
+            {
+                out << "FAIL  " << configuration.name << ": " << error << std::endl;
+                return 1;
+            }
+
+            Driver<SampleType> driver(processor);
+            auto check = [&](const String& phase)
+            {
+                if (! reportCheck(out, configuration.name + ", " + phase, options))
+                    ++numFailed;
+            };
+
+            for (auto numChannels : { 2, 1, 6 })
+            {
+                const auto layout = String(numChannels) + "ch";
+
+                if (! driver.prepare(numChannels, options.sampleRate, options.blockSize))
+                {
+                    out << "skip  " << configuration.name << ", " << layout << " not supported" << std::endl;
+                    continue;
+                }
+
+                clearViolations();
+                driver.process(options.numBlocks, false, false);
+                check(layout + " process");
+
+                driver.process(options.numBlocks, true, false);
+                check(layout + " shorter blocks");
+
+                driver.process(options.numBlocks, false, true);
+                driver.process(options.numBlocks / 4, false, false);
+                check(layout + " silence and back");
+
+                // Hosts deliver automation on the audio thread through setValue();
+                // the listener notification that follows is the host wrapper's.
+                auto& parameters = processor.getParameters();
+                int step = 0;
+
+                driver.process(options.numBlocks, true, false, [&]
+                {
+                    auto* parameter = parameters[step % parameters.size()];
+                    parameter->setValue((float) ((step / parameters.size()) % 17) / 16.0f);
+                    ++step;
+                });
+                check(layout + " parameter sweep");
+
+                // Program changes from the message thread: bursts that land on
+                // running crossfades, with pauses that let them finish. The
+                // first layout ramps to them; the crossfade engine is made by
+                // the next prepare.
+                {
+                    std::atomic<bool> stop { false };
+                    std::thread changer([&]
+                    {
+                        for (int i = 0; ! stop; ++i)
+                        {
+                            processor.setCurrentProgram(i % processor.getNumPrograms());
+
+                            if (i % 4 == 3)
+                                Thread::sleep(2);
+                        }
+                    });
+
+                    driver.process(options.numBlocks, true, false);
+                    stop = true;
+                    changer.join();
+                    check(layout + " program changes during playback");
+                }
+
+                processor.getMeterQueue().attachReader();
+                driver.process(options.numBlocks, true, false);
+                processor.getMeterQueue().detachReader();
+                check(layout + " metering");
+
+                // A session load or preset change while playing: the state is
+                // restored on another thread while the audio thread processes.
+                MemoryBlock states[2];
+                processor.getStateInformation(states[0]);
+
+                for (auto* parameter : parameters)
+                    parameter->setValueNotifyingHost(1.0f - parameter->getValue());
+
+                processor.getStateInformation(states[1]);
+
+                std::atomic<bool> stop { false };
+                std::thread restorer([&]
+                {
+                    for (int i = 0; ! stop; ++i)
+                        processor.setStateInformation(states[i & 1].getData(), (int) states[i & 1].getSize());
+                });
+
+                driver.process(options.numBlocks, false, false);
+                stop = true;
+                restorer.join();
+                check(layout + " state restore during playback");
+            }
+
+            // Sample rate and block size change, as when the host's audio device changes
+            if (driver.prepare(2, options.sampleRate * 2.0, options.blockSize * 2))
+            {
+                clearViolations();
+                driver.process(options.numBlocks, true, false);
+                check("2ch after sample rate change");
+            }
+
+            return numFailed;
+        }
+    }
+
+    // Runs every scenario and prints one line per check; returns the number of failed checks.
+    inline int run(std::ostream& out, const Options& options)
+    {
+        warmUp();
+
+        Array<detail::Configuration> configurations;
+
+        for (auto doublePrecision : { false, true })
+        {
+            const String precision = doublePrecision ? " double" : " float";
+
+            for (auto quality : { BassBoostQuality::reference, BassBoostQuality::fast, BassBoostQuality::draft })
+            {
+                detail::Configuration configuration;
+                configuration.name = "fused " + HostUtil::getQualityName(quality) + precision;
+                configuration.settings.engine = PluginAudioProcessor::Engine::fused;
+                configuration.settings.quality = quality;
+                configuration.doublePrecision = doublePrecision;
+                configurations.add(configuration);
+            }
+
+            for (auto blendMode : { BassBoostBlendMode::inPlace, BassBoostBlendMode::mixer })
+            {
+                detail::Configuration configuration;
+                configuration.name = "chain " + HostUtil::getBlendModeName(blendMode) + precision;
+                configuration.settings.engine = PluginAudioProcessor::Engine::chain;
+                configuration.settings.blendMode = blendMode;
+                configuration.doublePrecision = doublePrecision;
+                configurations.add(configuration);
+            }
+
+            detail::Configuration envelope;
+            envelope.name = "fused envelope detector" + precision;
+            envelope.settings.engine = PluginAudioProcessor::Engine::fused;
+            envelope.settings.detector = BassBoostDetector::envelope;
+            envelope.doublePrecision = doublePrecision;
+            configurations.add(envelope);
+
+            for (auto engine : { PluginAudioProcessor::Engine::fused, PluginAudioProcessor::Engine::chain })
+            {
+                for (auto oversampling : { BassBoostOversampling::x2, BassBoostOversampling::x4 })
+                {
+                    detail::Configuration configuration;
+                    configuration.name = HostUtil::getEngineName(engine) + " oversampled " + HostUtil::getOversamplingName(oversampling) + "x" + precision;
+                    configuration.settings.engine = engine;
+                    configuration.settings.oversampling = oversampling;
+                    configuration.doublePrecision = doublePrecision;
+                    configurations.add(configuration);
+                }
+            }
+
+            detail::Configuration tables;
+            tables.name = "fused coefficient tables, no sub-blocks" + precision;
+            tables.settings.engine = PluginAudioProcessor::Engine::fused;
+            tables.settings.coefficientTables = true;
+            tables.settings.subBlockSize = 0;
+            tables.doublePrecision = doublePrecision;
+            configurations.add(tables);
+        }
+
+        int numFailed = 0;
+
+        for (auto& configuration : configurations)
+            numFailed += configuration.doublePrecision ? detail::runConfiguration<double>(out, configuration, options)
+                                                       : detail::runConfiguration<float>(out, configuration, options);
+
+        out << std::endl << (numFailed == 0 ? "real-time safe" : String(numFailed) + " checks failed") << std::endl;
+        return numFailed;
+    }
+   #else
+    inline int run(std::ostream& out, const Options&)
+    {
+        out << "The real-time check replaces malloc and pthread calls, which is only implemented for Linux with glibc" << std::endl;
+        return 1;
+    }
+   #endif
+}
+
+#if DAMNBASSBOOST_REALTIME_CHECK
+//==============================================================================
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+
+    void* malloc(size_t size)
+    {
+        RealtimeCheck::detail::report(RealtimeCheck::allocation);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        RealtimeCheck::detail::report(RealtimeCheck::allocation);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        RealtimeCheck::detail::report(RealtimeCheck::allocation);
+        return __libc_realloc(pointer, size);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        RealtimeCheck::detail::report(RealtimeCheck::allocation);
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        RealtimeCheck::detail::report(RealtimeCheck::allocation);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size)
+    {
+        RealtimeCheck::detail::report(RealtimeCheck::allocation);
+
+        if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        *result = __libc_memalign(alignment, size);
+        return *result != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    void free(void* pointer)
+    {
+        if (pointer != nullptr)
+            RealtimeCheck::detail::report(RealtimeCheck::deallocation);
+
+        __libc_free(pointer);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        using Function = int (*)(pthread_mutex_t*);
+        static std::atomic<Function> next { nullptr };
+
+        RealtimeCheck::detail::report(RealtimeCheck::lock);
+        return RealtimeCheck::detail::findNext(next, "pthread_mutex_lock")(mutex);
+    }
+
+    int pthread_rwlock_rdlock(pthread_rwlock_t* rwlock)
+    {
+        using Function = int (*)(pthread_rwlock_t*);
+        static std::atomic<Function> next { nullptr };
+
+        RealtimeCheck::detail::report(RealtimeCheck::lock);
+        return RealtimeCheck::detail::findNext(next, "pthread_rwlock_rdlock")(rwlock);
+    }
+
+    int pthread_rwlock_wrlock(pthread_rwlock_t* rwlock)
+    {
+        using Function = int (*)(pthread_rwlock_t*);
+        static std::atomic<Function> next { nullptr };
+
+        RealtimeCheck::detail::report(RealtimeCheck::lock);
+        return RealtimeCheck::detail::findNext(next, "pthread_rwlock_wrlock")(rwlock);
+    }
+
+    int nanosleep(const struct timespec* duration, struct timespec* remaining)
+    {
+        using Function = int (*)(const struct timespec*, struct timespec*);
+        static std::atomic<Function> next { nullptr };
+
+        RealtimeCheck::detail::report(RealtimeCheck::sleep);
+        return RealtimeCheck::detail::findNext(next, "nanosleep")(duration, remaining);
+    }
+
+    int clock_nanosleep(clockid_t clock, int flags, const struct timespec* duration, struct timespec* remaining)
+    {
+        using Function = int (*)(clockid_t, int, const struct timespec*, struct timespec*);
+        static std::atomic<Function> next { nullptr };
+
+        RealtimeCheck::detail::report(RealtimeCheck::sleep);
+        return RealtimeCheck::detail::findNext(next, "clock_nanosleep")(clock, flags, duration, remaining);
+    }
+
+    int usleep(useconds_t microseconds)
+    {
+        using Function = int (*)(useconds_t);
+        static std::atomic<Function> next { nullptr };
+
+        RealtimeCheck::detail::report(RealtimeCheck::sleep);
+        return RealtimeCheck::detail::findNext(next, "usleep")(microseconds);
+    }
+
+    ssize_t read(int fd, void* data, size_t size)
+    {
+        using Function = ssize_t (*)(int, void*, size_t);
+        static std::atomic<Function> next { nullptr };
+
+        RealtimeCheck::detail::report(RealtimeCheck::fileIo);
+        return RealtimeCheck::detail::findNext(next, "read")(fd, data, size);
+    }
+
+    ssize_t write(int fd, const void* data, size_t size)
+    {
+        using Function = ssize_t (*)(int, const void*, size_t);
+        static std::atomic<Function> next { nullptr };
+
+        RealtimeCheck::detail::report(RealtimeCheck::fileIo);
+        return RealtimeCheck::detail::findNext(next, "write")(fd, data, size);
+    }
+}
+#endif
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "../Common/HostUtil.h"
+
+#include <chrono>
+
+//==============================================================================
+// Times a session recall: constructing many instances, restoring a state blob
+// into each and preparing them, as a host loading a large project does. Then
+// times opening an editor (construction and a first paint into an image) once
+// with a single instance in the process and once with all of them, which
+// should cost the same: editors share their look and feel, logo and meter
+// timer rather than paying per instance. The first paint of each measurement
+// is also broken down by area, from the PaintProfiler in the shared look and
+// feel, reset once the editor exists so it holds that paint alone.
+namespace StartupBenchmark
+{
+    struct Result
+    {
+        int numInstances = 0;
+        double constructUs = 0.0;        // per instance
+        double restoreUs = 0.0;          // per instance
+        double prepareUs = 0.0;          // per instance
+        double firstEditorUs = 0.0;      // the first editor in the process, which creates the shared resources
+        double editorUs = 0.0;           // mean editor open with one instance
+        double editorAtScaleUs = 0.0;    // mean editor open with numInstances instances
+        PaintProfiler firstEditorPaints, editorPaints, editorAtScalePaints;    // of the last open of each
+        String error;
+    };
+
+    inline Result run(int numInstances, double sampleRate, int blockSize, int numChannels,
+                      const HostUtil::ProcessorSettings& settings)
+    {
+        using Clock = std::chrono::steady_clock;
+        auto microseconds = [](Clock::time_point start) { return std::chrono::duration<double, std::micro>(Clock::now() - start).count(); };
+
+        Result result;
+        result.numInstances = numInstances;
+
+        // The session's state blob: the settings applied to a template instance.
+        MemoryBlock state;
+
+        {
+            PluginAudioProcessor processor;
+            result.error = HostUtil::applySettings(processor, settings);
+
+            if (result.error.isNotEmpty())
+                return result;
+
+            processor.getStateInformation(state);
+        }
+
+        auto engineSettings = settings;
+        engineSettings.state.reset();
+        engineSettings.parameters.clear();
+
+        OwnedArray<PluginAudioProcessor> processors;
+        processors.ensureStorageAllocated(numInstances);
+
+        auto addInstances = [&](int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                auto start = Clock::now();
+                auto* processor = processors.add(new PluginAudioProcessor());
+                result.constructUs += microseconds(start);
+
+                start = Clock::now();
+                processor->setStateInformation(state.getData(), (int) state.getSize());
+                result.restoreUs += microseconds(start);
+
+                HostUtil::applySettings(*processor, engineSettings);
+
+                if (! HostUtil::setChannelLayout(*processor, numChannels))
+                {
+                    result.error = "Unsupported channel count";
+                    return;
+                }
+
+                start = Clock::now();
+                processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+                processor->prepareToPlay(sampleRate, blockSize);
+                result.prepareUs += microseconds(start);
+            }
+        };
+
+        auto openEditor = [&](PluginAudioProcessor& processor, PaintProfiler& paints)
+        {
+            auto start = Clock::now();
+            std::unique_ptr<AudioProcessorEditor> editor(processor.createEditor());
+            auto elapsed = microseconds(start);
+
+            // The editor's own, while it keeps the look and feel alive
+            SharedResourcePointer<CustomLookAndFeel> lookAndFeel;
+            lookAndFeel->paintProfiler.reset();
+
+            start = Clock::now();
+            editor->createComponentSnapshot(editor->getLocalBounds());
+            elapsed += microseconds(start);
+
+            paints = lookAndFeel->paintProfiler;
+            return elapsed;
+        };
+
+        constexpr int numEditorRepeats = 10;
+
+        addInstances(1);
+
+        if (result.error.isNotEmpty())
+            return result;
+
+        result.firstEditorUs = openEditor(*processors.getFirst(), result.firstEditorPaints);
+
+        for (int i = 0; i < numEditorRepeats; ++i)
+            result.editorUs += openEditor(*processors.getFirst(), result.editorPaints) / numEditorRepeats;
+
+        addInstances(numInstances - 1);
+
+        if (result.error.isNotEmpty())
+            return result;
+
+        for (int i = 0; i < numEditorRepeats; ++i)
+            result.editorAtScaleUs += openEditor(*processors.getLast(), result.editorAtScalePaints) / numEditorRepeats;
+
+        result.constructUs /= numInstances;
+        result.restoreUs /= numInstances;
+        result.prepareUs /= numInstances;
+        return result;
+    }
+}
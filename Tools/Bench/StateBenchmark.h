@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../Common/HostUtil.h"
+
+#include <chrono>
+
+//==============================================================================
+// Times getStateInformation and setStateInformation over many processor
+// instances, as a host saving and loading a large session would, for the
+// binary state and for the XML state of earlier versions.
+namespace StateBenchmark
+{
+    enum class Format
+    {
+        binary,
+        xml,
+    };
+
+    struct Result
+    {
+        Format format = Format::binary;
+        int numInstances = 0;
+        double saveUs = 0.0;    // per instance
+        double restoreUs = 0.0; // per instance
+        size_t bytes = 0;       // per instance
+    };
+
+    inline String getFormatName(Format format)
+    {
+        return format == Format::binary ? "binary" : "xml";
+    }
+
+    // Every instance gets different parameter values, and restores the state
+    // of its neighbour, so each restore changes every parameter.
+    inline Result run(Format format, int numInstances, int numRepeats)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        OwnedArray<PluginAudioProcessor> processors;
+        Random random(0x5eed);
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            auto* processor = processors.add(new PluginAudioProcessor());
+
+            for (auto* parameter : processor->getParameters())
+                parameter->setValueNotifyingHost(random.nextFloat());
+        }
+
+        std::vector<MemoryBlock> states((size_t) numInstances);
+        double saveNs = 0.0, restoreNs = 0.0;
+
+        for (int repeat = 0; repeat < numRepeats; ++repeat)
+        {
+            auto start = Clock::now();
+
+            for (int i = 0; i < numInstances; ++i)
+            {
+                auto& state = states[(size_t) i];
+                state.reset();
+
+                if (format == Format::binary)
+                    processors[i]->getStateInformation(state);
+                else
+                    processors[i]->getXmlStateInformation(state);
+            }
+
+            auto saved = Clock::now();
+
+            for (int i = 0; i < numInstances; ++i)
+            {
+                auto& state = states[(size_t) ((i + 1) % numInstances)];
+                processors[i]->setStateInformation(state.getData(), (int) state.getSize());
+            }
+
+            auto restored = Clock::now();
+
+            saveNs += std::chrono::duration<double, std::nano>(saved - start).count();
+            restoreNs += std::chrono::duration<double, std::nano>(restored - saved).count();
+        }
+
+        Result result;
+        result.format = format;
+        result.numInstances = numInstances;
+        result.saveUs = saveNs / 1000.0 / ((double) numRepeats * numInstances);
+        result.restoreUs = restoreNs / 1000.0 / ((double) numRepeats * numInstances);
+        result.bytes = states.front().getSize();
+        return result;
+    }
+}
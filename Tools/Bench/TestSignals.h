@@ -0,0 +1,96 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+
+//==============================================================================
+// Deterministic synthetic inputs for the benchmarks. Every signal is generated
+// from a fixed seed so runs on different machines process identical data.
+namespace TestSignals
+{
+    inline StringArray getNames()
+    {
+        return { "silence", "sweep", "noise", "program" };
+    }
+
+    // Logarithmic sine sweep from 20 Hz to 20 kHz (or just below Nyquist) at -12 dBFS.
+    inline void fillSweep(AudioBuffer<float>& buffer, double sampleRate)
+    {
+        auto numSamples = buffer.getNumSamples();
+        auto startFreq = 20.0;
+        auto endFreq = jmin(20000.0, sampleRate * 0.45);
+        auto level = Decibels::decibelsToGain(-12.0f);
+        auto phase = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto freq = startFreq * std::pow(endFreq / startFreq, (double) i / numSamples);
+            auto sample = level * (float) std::sin(phase);
+            phase = std::fmod(phase + MathConstants<double>::twoPi * freq / sampleRate, MathConstants<double>::twoPi);
+
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                buffer.setSample(ch, i, sample);
+        }
+    }
+
+    // White noise at -12 dBFS, decorrelated between channels.
+    inline void fillNoise(AudioBuffer<float>& buffer)
+    {
+        Random random(0x5eed);
+        auto level = Decibels::decibelsToGain(-12.0f);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(ch, i, level * (random.nextFloat() * 2.0f - 1.0f));
+    }
+
+    // A rough stand-in for a mix: kicks, a moving bass line and hats, with the
+    // overall level drifting so the dynamic boost has something to follow.
+    inline void fillProgram(AudioBuffer<float>& buffer, double sampleRate)
+    {
+        Random random(0xb055);
+        static const float bassNotes[] = { 41.2f, 55.0f, 49.0f, 61.7f };
+
+        auto kickInterval = (int) (sampleRate * 0.5);
+        auto noteLength = (int) (sampleRate * 0.25);
+        auto hatInterval = (int) (sampleRate * 0.125);
+        auto bassPhase = 0.0;
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            auto t = (double) i / sampleRate;
+
+            auto kickTime = (double) (i % kickInterval) / sampleRate;
+            auto kickFreq = 45.0 + 90.0 * std::exp(-kickTime * 30.0);
+            auto kick = 0.8 * std::exp(-kickTime * 8.0) * std::sin(MathConstants<double>::twoPi * kickFreq * kickTime);
+
+            auto bassFreq = bassNotes[(i / noteLength) % numElementsInArray(bassNotes)];
+            bassPhase = std::fmod(bassPhase + MathConstants<double>::twoPi * bassFreq / sampleRate, MathConstants<double>::twoPi);
+            auto bass = 0.3 * std::sin(bassPhase) + 0.1 * std::sin(2.0 * bassPhase);
+
+            auto hatTime = (double) (i % hatInterval) / sampleRate;
+            auto hatEnvelope = 0.1 * std::exp(-hatTime * 60.0);
+
+            auto drift = Decibels::decibelsToGain(-18.0 + 12.0 * std::sin(MathConstants<double>::twoPi * 0.2 * t));
+
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            {
+                auto hat = hatEnvelope * (random.nextDouble() * 2.0 - 1.0);
+                buffer.setSample(ch, i, (float) (drift * (kick + bass + hat)));
+            }
+        }
+    }
+
+    inline bool fill(const String& name, AudioBuffer<float>& buffer, double sampleRate)
+    {
+        buffer.clear();
+
+        if (name == "silence")  return true;
+        if (name == "sweep")    { fillSweep(buffer, sampleRate);   return true; }
+        if (name == "noise")    { fillNoise(buffer);               return true; }
+        if (name == "program")  { fillProgram(buffer, sampleRate); return true; }
+
+        return false;
+    }
+}
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "../../Source/DamnBassBoost.h"
+
+using namespace juce;
+
+//==============================================================================
+// Helpers shared by the command line tools that drive PluginAudioProcessor
+// directly, without a plugin host or an editor.
+namespace HostUtil
+{
+    struct ParameterSetting
+    {
+        String id;
+        float value = 0.0f;
+    };
+
+    struct ProcessorSettings
+    {
+        MemoryBlock state;
+        Array<ParameterSetting> parameters;
+        PluginAudioProcessor::Engine engine = PluginAudioProcessor::Engine::chain;
+        bool coefficientTables = false;
+        BassBoostBlendMode blendMode = BassBoostBlendMode::mixer;
+        BassBoostQuality quality = BassBoostQuality::reference;
+        BassBoostInstructionSet instructionSet = BassBoostInstructionSet::automatic;
+        BassBoostOversampling oversampling = BassBoostOversampling::x1;
+        BassBoostDetector detector = BassBoostDetector::compressor;
+        int subBlockSize = 32;
+        int program = -1; // a PresetBank program, applied after state and before parameters
+    };
+
+    inline StringArray getEngineNames()
+    {
+        return { "chain", "fused" };
+    }
+
+    inline String getEngineName(PluginAudioProcessor::Engine engine)
+    {
+        return getEngineNames()[(int) engine];
+    }
+
+    inline bool parseEngine(const String& text, PluginAudioProcessor::Engine& result)
+    {
+        auto index = getEngineNames().indexOf(text.trim(), true);
+
+        if (index < 0)
+            return false;
+
+        result = (PluginAudioProcessor::Engine) index;
+        return true;
+    }
+
+    inline StringArray getBlendModeNames()
+    {
+        return { "inplace", "mixer" };
+    }
+
+    inline String getBlendModeName(BassBoostBlendMode blendMode)
+    {
+        return getBlendModeNames()[(int) blendMode];
+    }
+
+    inline bool parseBlendMode(const String& text, BassBoostBlendMode& result)
+    {
+        auto index = getBlendModeNames().indexOf(text.trim(), true);
+
+        if (index < 0)
+            return false;
+
+        result = (BassBoostBlendMode) index;
+        return true;
+    }
+
+    inline StringArray getQualityNames()
+    {
+        return { "reference", "fast", "draft" };
+    }
+
+    inline String getQualityName(BassBoostQuality quality)
+    {
+        return getQualityNames()[(int) quality];
+    }
+
+    inline bool parseQuality(const String& text, BassBoostQuality& result)
+    {
+        auto index = getQualityNames().indexOf(text.trim(), true);
+
+        if (index < 0)
+            return false;
+
+        result = (BassBoostQuality) index;
+        return true;
+    }
+
+    inline StringArray getInstructionSetNames()
+    {
+        return { "auto", "baseline", "avx2", "avx512" };
+    }
+
+    inline bool parseInstructionSet(const String& text, BassBoostInstructionSet& result)
+    {
+        auto index = getInstructionSetNames().indexOf(text.trim(), true);
+
+        if (index < 0)
+            return false;
+
+        result = (BassBoostInstructionSet) index;
+        return true;
+    }
+
+    inline StringArray getDetectorNames()
+    {
+        return { "compressor", "envelope" };
+    }
+
+    inline String getDetectorName(BassBoostDetector detector)
+    {
+        return getDetectorNames()[(int) detector];
+    }
+
+    inline bool parseDetector(const String& text, BassBoostDetector& result)
+    {
+        auto index = getDetectorNames().indexOf(text.trim(), true);
+
+        if (index < 0)
+            return false;
+
+        result = (BassBoostDetector) index;
+        return true;
+    }
+
+    inline StringArray getProgramNames()
+    {
+        StringArray names;
+
+        for (auto& preset : PresetBank::presets)
+            names.add(preset.name);
+
+        return names;
+    }
+
+    // A program number from 0, or a name without regard to case.
+    inline bool parseProgram(const String& text, int& result)
+    {
+        auto trimmed = text.trim();
+        auto index = trimmed.containsOnly("0123456789") && trimmed.isNotEmpty() ? trimmed.getIntValue()
+                                                                                : getProgramNames().indexOf(trimmed, true);
+
+        if (! isPositiveAndBelow(index, PresetBank::numPresets))
+            return false;
+
+        result = index;
+        return true;
+    }
+
+    // The factors, "1", "2" and "4".
+    inline StringArray getOversamplingNames()
+    {
+        return { "1", "2", "4" };
+    }
+
+    inline String getOversamplingName(BassBoostOversampling oversampling)
+    {
+        return getOversamplingNames()[(int) oversampling];
+    }
+
+    inline bool parseOversampling(const String& text, BassBoostOversampling& result)
+    {
+        auto index = getOversamplingNames().indexOf(text.trim().trimCharactersAtEnd("xX"), true);
+
+        if (index < 0)
+            return false;
+
+        result = (BassBoostOversampling) index;
+        return true;
+    }
+
+    // Parses "<id>=<value>", e.g. "boostFreq=80".
+    inline bool parseParameterSetting(const String& text, ParameterSetting& result)
+    {
+        if (! text.containsChar('='))
+            return false;
+
+        result.id = text.upToFirstOccurrenceOf("=", false, false).trim();
+        auto valueText = text.fromFirstOccurrenceOf("=", false, false).trim();
+
+        if (result.id.isEmpty() || ! valueText.containsAnyOf("0123456789"))
+            return false;
+
+        result.value = valueText.getFloatValue();
+        return true;
+    }
+
+    inline RangedAudioParameter* findParameter(AudioProcessor& processor, const String& id)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* ranged = dynamic_cast<RangedAudioParameter*>(parameter))
+                if (ranged->paramID == id)
+                    return ranged;
+
+        return nullptr;
+    }
+
+    // Sets a parameter from its real-world value (dB, ms, Hz...).
+    inline bool applyParameter(AudioProcessor& processor, const ParameterSetting& setting)
+    {
+        if (auto* parameter = findParameter(processor, setting.id))
+        {
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(setting.value));
+            return true;
+        }
+
+        return false;
+    }
+
+    // Restores the state blob first so that individual parameters can override it.
+    inline String applySettings(PluginAudioProcessor& processor, const ProcessorSettings& settings)
+    {
+        processor.setEngine(settings.engine);
+        processor.setUseCoefficientTables(settings.coefficientTables);
+        processor.setBlendMode(settings.blendMode);
+        processor.setQuality(settings.quality);
+        processor.setInstructionSet(settings.instructionSet);
+        processor.setOversampling(settings.oversampling);
+        processor.setDetector(settings.detector);
+        processor.setSubBlockSize(settings.subBlockSize);
+
+        if (settings.state.getSize() > 0)
+            processor.setStateInformation(settings.state.getData(), (int) settings.state.getSize());
+
+        if (settings.program >= 0)
+            processor.setCurrentProgram(settings.program);
+
+        for (auto& setting : settings.parameters)
+            if (! applyParameter(processor, setting))
+                return "Unknown parameter: " + setting.id;
+
+        return {};
+    }
+
+    // The processor's current parameter values, for driving the DSP classes directly.
+    inline BassBoostParameters getBassBoostParameters(AudioProcessor& processor)
+    {
+        auto getValue = [&](const String& id)
+        {
+            auto* parameter = findParameter(processor, id);
+            jassert(parameter != nullptr);
+            return parameter->convertFrom0to1(parameter->getValue());
+        };
+
+        BassBoostParameters parameters;
+        parameters.preGain = getValue("preGain");
+        parameters.speed = getValue("speed");
+        parameters.ratio = getValue("ratio");
+        parameters.boostFreq = getValue("boostFreq");
+        parameters.boostDrive = getValue("boostDrive");
+        parameters.amount = getValue("amount");
+        parameters.postGain = getValue("postGain");
+        parameters.linkDetector = getValue("linkDetector") >= 0.5f;
+        return parameters;
+    }
+
+    inline bool setChannelLayout(AudioProcessor& processor, int numChannels)
+    {
+        auto channelSet = AudioChannelSet::canonicalChannelSet(numChannels);
+
+        if (channelSet.isDisabled())
+            channelSet = AudioChannelSet::discreteChannels(numChannels);
+
+        AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(channelSet);
+        layout.outputBuses.add(channelSet);
+
+        return processor.setBusesLayout(layout);
+    }
+
+    inline String getParameterHelp(AudioProcessor& processor)
+    {
+        String help;
+
+        for (auto* parameter : processor.getParameters())
+            if (auto* ranged = dynamic_cast<RangedAudioParameter*>(parameter))
+            {
+                auto& range = ranged->getNormalisableRange();
+                help << "    " << ranged->paramID.paddedRight(' ', 12)
+                     << String(range.start) << " .. " << String(range.end)
+                     << " (default " << String(range.convertFrom0to1(ranged->getDefaultValue())) << ")" << newLine;
+            }
+
+        return help;
+    }
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "../Common/HostUtil.h"
+
+//==============================================================================
+// Renders a list of audio files through PluginAudioProcessor on a thread pool.
+// Every worker owns one processor instance and pulls the next file from a
+// shared counter, so long and short files balance across the cores. Outputs
+// are compensated for the processor's latency (oversampling): that many
+// samples are trimmed from the head and rendered past the end of the input,
+// so each output lines up with its input and has the same length.
+class BatchRenderer
+{
+public:
+    struct Task
+    {
+        File input;
+        File output;
+    };
+
+    struct Result
+    {
+        double audioSeconds = 0.0;
+        double wallSeconds = 0.0;
+        String error;
+
+        double getRealtimeMultiple() const { return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0; }
+    };
+
+    BatchRenderer(const HostUtil::ProcessorSettings& settingsToUse, int blockSizeToUse, int bitDepthToUse)
+        : settings(settingsToUse), blockSize(blockSizeToUse), bitDepth(bitDepthToUse)
+    {
+    }
+
+   #if DAMNBASSBOOST_PROFILE_STAGES
+    // Keeps every stage event of the render, one track per worker.
+    void setProfileStages(bool shouldProfile) { profileStages = shouldProfile; }
+
+    // After render(): the events and the summary of each worker.
+    const std::vector<StageProfiler::Track>& getStageTracks() const noexcept { return stageTracks; }
+    const StringArray& getStageSummaries() const noexcept { return stageSummaries; }
+    double getCyclesPerMicrosecond() const noexcept { return cyclesPerMicrosecond; }
+   #endif
+
+    // A writer for task.output in the format its extension names, with the
+    // reader's rate, channels and metadata. bitDepth 0 keeps the reader's; a
+    // depth the format lacks becomes its highest.
+    static std::unique_ptr<AudioFormatWriter> createWriter(AudioFormatManager& formatManager, const Task& task,
+                                                           const AudioFormatReader& reader, int bitDepth, String& error)
+    {
+        auto* format = formatManager.findFormatForFileExtension(task.output.getFileExtension());
+
+        if (format == nullptr)
+        {
+            error = "No writer for " + task.output.getFileName();
+            return {};
+        }
+
+        auto bitDepths = format->getPossibleBitDepths();
+        auto bits = bitDepth > 0 ? bitDepth : (int) reader.bitsPerSample;
+
+        if (! bitDepths.contains(bits))
+            bits = bitDepths.getLast();
+
+        task.output.deleteFile();
+        std::unique_ptr<FileOutputStream> stream(task.output.createOutputStream());
+        std::unique_ptr<AudioFormatWriter> writer;
+
+        if (stream != nullptr)
+            writer.reset(format->createWriterFor(stream.get(), reader.sampleRate, reader.numChannels, bits, reader.metadataValues, 0));
+
+        if (writer == nullptr)
+        {
+            error = "Cannot write " + task.output.getFullPathName();
+            return {};
+        }
+
+        stream.release(); // now owned by the writer
+        return writer;
+    }
+
+    // Returns one result per task, in the same order as the tasks.
+    std::vector<Result> render(const Array<Task>& tasksToRender, int numWorkers)
+    {
+        tasks = tasksToRender;
+        results.assign((size_t) tasks.size(), {});
+        nextTask = 0;
+
+        numWorkers = jlimit(1, jmax(1, tasks.size()), numWorkers);
+
+        // Processors are created and destroyed on this thread; the workers only process.
+        OwnedArray<RenderWorker> workers;
+
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            auto processor = std::make_unique<PluginAudioProcessor>();
+            auto error = HostUtil::applySettings(*processor, settings);
+
+            if (error.isNotEmpty())
+            {
+                for (auto& result : results)
+                    result.error = error;
+
+                return results;
+            }
+
+            workers.add(new RenderWorker(*this, std::move(processor)));
+        }
+
+        ThreadPool pool(numWorkers);
+
+        for (auto* worker : workers)
+            pool.addJob(worker, false);
+
+        for (auto* worker : workers)
+            pool.waitForJobToFinish(worker, -1);
+
+       #if DAMNBASSBOOST_PROFILE_STAGES
+        stageTracks.clear();
+        stageSummaries.clear();
+
+        if (profileStages)
+        {
+            for (int i = 0; i < workers.size(); ++i)
+            {
+                auto& profiler = workers[i]->getProcessor().getStageProfiler();
+                stageTracks.push_back({ "worker " + String(i + 1), std::move(workers[i]->stageEvents) });
+                stageSummaries.add(profiler.getSummary());
+                cyclesPerMicrosecond = profiler.getCyclesPerMicrosecond();
+            }
+        }
+       #endif
+
+        return results;
+    }
+
+private:
+    //==============================================================================
+    class RenderWorker : public ThreadPoolJob
+    {
+    public:
+        RenderWorker(BatchRenderer& o, std::unique_ptr<PluginAudioProcessor> p)
+            : ThreadPoolJob("RenderWorker"), owner(o), processor(std::move(p))
+        {
+            formatManager.registerBasicFormats();
+        }
+
+        JobStatus runJob() override
+        {
+            for (;;)
+            {
+                auto index = owner.nextTask++;
+
+                if (index >= owner.tasks.size() || shouldExit())
+                    break;
+
+                owner.results[(size_t) index] = renderFile(owner.tasks.getReference(index));
+            }
+
+            return jobHasFinished;
+        }
+
+        PluginAudioProcessor& getProcessor() noexcept { return *processor; }
+
+       #if DAMNBASSBOOST_PROFILE_STAGES
+        std::vector<StageProfiler::Event> stageEvents;
+       #endif
+
+    private:
+        Result renderFile(const Task& task)
+        {
+            Result result;
+
+            std::unique_ptr<AudioFormatReader> reader(formatManager.createReaderFor(task.input));
+
+            if (reader == nullptr)
+            {
+                result.error = "Cannot read " + task.input.getFullPathName();
+                return result;
+            }
+
+            auto numChannels = (int) reader->numChannels;
+            auto sampleRate = reader->sampleRate;
+            auto blockSize = owner.blockSize;
+
+            if (! HostUtil::setChannelLayout(*processor, numChannels))
+            {
+                result.error = "Unsupported channel count (" + String(numChannels) + ") in " + task.input.getFileName();
+                return result;
+            }
+
+            auto writer = createWriter(formatManager, task, *reader, owner.bitDepth, result.error);
+
+            if (writer == nullptr)
+                return result;
+
+            AudioBuffer<float> buffer(numChannels, blockSize);
+            MidiBuffer midi;
+
+            auto startTime = Time::getMillisecondCounterHiRes();
+
+            processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+            processor->prepareToPlay(sampleRate, blockSize);
+
+            const auto latency = (int64) processor->getLatencySamples();
+            const auto total = reader->lengthInSamples + latency;
+
+            // Past the end of the input the reader gives silence
+            for (int64 position = 0; position < total; position += blockSize)
+            {
+                auto numSamples = (int) jmin((int64) blockSize, total - position);
+
+                buffer.setSize(numChannels, numSamples, false, false, true);
+                reader->read(&buffer, 0, numSamples, position, true, true);
+                processor->processBlock(buffer, midi);
+
+                const auto skip = (int) jlimit((int64) 0, (int64) numSamples, latency - position);
+
+                if (skip < numSamples)
+                    writer->writeFromAudioSampleBuffer(buffer, skip, numSamples - skip);
+
+               #if DAMNBASSBOOST_PROFILE_STAGES
+                if (owner.profileStages)
+                    processor->getStageProfiler().readEvents(stageEvents);
+               #endif
+            }
+
+            processor->releaseResources();
+            writer.reset();
+
+            result.wallSeconds = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+            result.audioSeconds = (double) reader->lengthInSamples / sampleRate;
+
+            return result;
+        }
+
+        BatchRenderer& owner;
+        std::unique_ptr<PluginAudioProcessor> processor;
+        AudioFormatManager formatManager;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderWorker)
+    };
+
+    HostUtil::ProcessorSettings settings;
+    int blockSize;
+    int bitDepth;
+
+    Array<Task> tasks;
+    std::vector<Result> results;
+    std::atomic<int> nextTask{ 0 };
+
+   #if DAMNBASSBOOST_PROFILE_STAGES
+    bool profileStages = false;
+    std::vector<StageProfiler::Track> stageTracks;
+    StringArray stageSummaries;
+    double cyclesPerMicrosecond = 1.0;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchRenderer)
+};
@@ -0,0 +1,455 @@
+#include <JuceHeader.h>
+
+#include <iostream>
+
+#include "BatchRenderer.h"
+#include "PcmStream.h"
+#include "SegmentedRenderer.h"
+
+//==============================================================================
+static void printUsage()
+{
+    PluginAudioProcessor processor;
+
+    std::cout << "Usage: DamnBassBoostRender [options] <files or directories...>" << std::endl
+              << "       DamnBassBoostRender --stream [options] < input.pcm > output.pcm" << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "  --out <dir>            write results to <dir> (default: next to each input as <name>_boosted)" << std::endl
+              << "  --format <wav|flac>    output format (default: same as input)" << std::endl
+              << "  --bits <n>             output bit depth (default: same as input)" << std::endl
+              << "  --state <file>         load a state blob saved with --save-state or by a host" << std::endl
+              << "  --save-state <file>    write the resulting state blob and exit if no inputs are given" << std::endl
+              << "  --program <n|name>     load a factory program, applied after --state and before --param" << std::endl
+              << "  --param <id>=<value>   set a parameter, applied after --state (repeatable)" << std::endl
+              << "  --engine <chain|fused> DSP engine (default chain)" << std::endl
+              << "  --coefficient-tables   look ballistics/cutoff coefficients up in shared tables" << std::endl
+              << "  --blend <inplace|mixer> chain engine dry/wet sum, mixer is the DryWetMixer reference (default mixer)" << std::endl
+              << "  --quality <reference|fast|draft> tanh/pow accuracy of the fused engine (default reference)" << std::endl
+              << "  --isa <auto|baseline|avx2|avx512> instruction set of the fused kernel (default auto)" << std::endl
+              << "  --detector <compressor|envelope> fused engine detector, envelope runs at a control rate (default compressor)" << std::endl
+              << "  --oversampling <1|2|4> oversample the ladder filter; the filters' latency, a few samples," << std::endl
+              << "                         is trimmed so the output lines up with the input (default 1)" << std::endl
+              << "  --block <samples>      processing block size (default 512)" << std::endl
+              << "  --sub-block <samples>  parameter ramp step, 0 applies changes per block (default 32)" << std::endl
+              << "  --jobs <n>             worker threads, one processor each (default: all cores)" << std::endl
+              << "  --segment <seconds>    render each file in segments of this length on --jobs workers, each" << std::endl
+              << "                         warmed up on the audio before its segment (default off)" << std::endl
+              << "  --check-serial         with --segment, compare each output with a serial render" << std::endl
+              << "  --trace <file>         write the processBlock stages as a Chrome/Perfetto trace and print" << std::endl
+              << "                         cycles per stage (needs a build with DAMNBASSBOOST_PROFILE_STAGES=1)" << std::endl
+              << std::endl
+              << "Streaming (raw interleaved little-endian PCM, added latency one --block plus the processor's):" << std::endl
+              << "  --stream               process from --in-fd to --out-fd instead of files" << std::endl
+              << "  --pcm <f32|s16|s24|s32> sample format (default f32)" << std::endl
+              << "  --rate <hz>            sample rate (default 48000)" << std::endl
+              << "  --channels <n>         interleaved channels (default 2)" << std::endl
+              << "  --in-fd <n>            input file descriptor (default 0, stdin)" << std::endl
+              << "  --out-fd <n>           output file descriptor (default 1, stdout)" << std::endl
+              << "  --control <file>       file or named pipe of <id>=<value> lines, applied between blocks" << std::endl
+              << std::endl
+              << "Parameters:" << std::endl
+              << HostUtil::getParameterHelp(processor);
+}
+
+static void addInputs(const File& file, Array<File>& inputs)
+{
+    if (file.isDirectory())
+    {
+        for (const auto& entry : RangedDirectoryIterator(file, true, "*.wav;*.flac", File::findFiles))
+            inputs.add(entry.getFile());
+    }
+    else
+    {
+        inputs.add(file);
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI libraryInitialiser;
+
+    HostUtil::ProcessorSettings settings;
+    File outputDirectory, saveStateFile, traceFile;
+    String outputFormat;
+    Array<File> inputs;
+    int blockSize = 512;
+    int bitDepth = 0;
+    int numJobs = SystemStats::getNumCpus();
+    double segmentSeconds = 0.0;
+    bool checkSerial = false;
+    bool stream = false;
+    PcmStream::Options streamOptions;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        String arg(CharPointer_UTF8(argv[i]));
+        auto hasValue = i + 1 < argc;
+        auto nextValue = [&] { return String(CharPointer_UTF8(argv[++i])); };
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            return 0;
+        }
+        else if (arg == "--out" && hasValue)
+        {
+            outputDirectory = File::getCurrentWorkingDirectory().getChildFile(nextValue());
+        }
+        else if (arg == "--format" && hasValue)
+        {
+            outputFormat = nextValue().trimCharactersAtStart(".").toLowerCase();
+        }
+        else if (arg == "--bits" && hasValue)
+        {
+            bitDepth = nextValue().getIntValue();
+        }
+        else if (arg == "--state" && hasValue)
+        {
+            auto stateFile = File::getCurrentWorkingDirectory().getChildFile(nextValue());
+
+            if (! stateFile.loadFileAsData(settings.state))
+            {
+                std::cerr << "Cannot read state file " << stateFile.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--save-state" && hasValue)
+        {
+            saveStateFile = File::getCurrentWorkingDirectory().getChildFile(nextValue());
+        }
+        else if (arg == "--param" && hasValue)
+        {
+            HostUtil::ParameterSetting setting;
+
+            if (! HostUtil::parseParameterSetting(nextValue(), setting))
+            {
+                std::cerr << "Expected --param <id>=<value>" << std::endl;
+                return 1;
+            }
+
+            settings.parameters.add(setting);
+        }
+        else if (arg == "--engine" && hasValue)
+        {
+            if (! HostUtil::parseEngine(nextValue(), settings.engine))
+            {
+                std::cerr << "Expected --engine " << HostUtil::getEngineNames().joinIntoString("|") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--coefficient-tables")
+        {
+            settings.coefficientTables = true;
+        }
+        else if (arg == "--quality" && hasValue)
+        {
+            if (! HostUtil::parseQuality(nextValue(), settings.quality))
+            {
+                std::cerr << "Expected --quality " << HostUtil::getQualityNames().joinIntoString("|") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--isa" && hasValue)
+        {
+            if (! HostUtil::parseInstructionSet(nextValue(), settings.instructionSet))
+            {
+                std::cerr << "Expected --isa " << HostUtil::getInstructionSetNames().joinIntoString("|") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--program" && hasValue)
+        {
+            if (! HostUtil::parseProgram(nextValue(), settings.program))
+            {
+                std::cerr << "Expected --program 0-" << (PresetBank::numPresets - 1) << " or one of: "
+                          << HostUtil::getProgramNames().joinIntoString(", ") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--detector" && hasValue)
+        {
+            if (! HostUtil::parseDetector(nextValue(), settings.detector))
+            {
+                std::cerr << "Expected --detector " << HostUtil::getDetectorNames().joinIntoString("|") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--oversampling" && hasValue)
+        {
+            if (! HostUtil::parseOversampling(nextValue(), settings.oversampling))
+            {
+                std::cerr << "Expected --oversampling " << HostUtil::getOversamplingNames().joinIntoString("|") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--blend" && hasValue)
+        {
+            if (! HostUtil::parseBlendMode(nextValue(), settings.blendMode))
+            {
+                std::cerr << "Expected --blend " << HostUtil::getBlendModeNames().joinIntoString("|") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--block" && hasValue)
+        {
+            blockSize = jmax(1, nextValue().getIntValue());
+        }
+        else if (arg == "--sub-block" && hasValue)
+        {
+            settings.subBlockSize = jmax(0, nextValue().getIntValue());
+        }
+        else if (arg == "--jobs" && hasValue)
+        {
+            numJobs = jmax(1, nextValue().getIntValue());
+        }
+        else if (arg == "--segment" && hasValue)
+        {
+            segmentSeconds = jmax(0.0, nextValue().getDoubleValue());
+        }
+        else if (arg == "--check-serial")
+        {
+            checkSerial = true;
+        }
+        else if (arg == "--stream")
+        {
+            stream = true;
+        }
+        else if (arg == "--pcm" && hasValue)
+        {
+            if (! PcmStream::parseSampleFormat(nextValue(), streamOptions.format))
+            {
+                std::cerr << "Expected --pcm " << PcmStream::getSampleFormatNames().joinIntoString("|") << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--rate" && hasValue)
+        {
+            streamOptions.sampleRate = jmax(1.0, nextValue().getDoubleValue());
+        }
+        else if (arg == "--channels" && hasValue)
+        {
+            streamOptions.numChannels = jmax(1, nextValue().getIntValue());
+        }
+        else if (arg == "--in-fd" && hasValue)
+        {
+            streamOptions.inputDescriptor = nextValue().getIntValue();
+        }
+        else if (arg == "--out-fd" && hasValue)
+        {
+            streamOptions.outputDescriptor = nextValue().getIntValue();
+        }
+        else if (arg == "--control" && hasValue)
+        {
+            streamOptions.controlFile = File::getCurrentWorkingDirectory().getChildFile(nextValue());
+        }
+        else if (arg == "--trace" && hasValue)
+        {
+            traceFile = File::getCurrentWorkingDirectory().getChildFile(nextValue());
+        }
+        else if (arg.startsWith("-"))
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+        else
+        {
+            addInputs(File::getCurrentWorkingDirectory().getChildFile(arg), inputs);
+        }
+    }
+
+    if (saveStateFile != File())
+    {
+        PluginAudioProcessor processor;
+        auto error = HostUtil::applySettings(processor, settings);
+
+        if (error.isNotEmpty())
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+
+        MemoryBlock state;
+        processor.getStateInformation(state);
+
+        if (! saveStateFile.replaceWithData(state.getData(), state.getSize()))
+        {
+            std::cerr << "Cannot write " << saveStateFile.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        if (inputs.isEmpty() && ! stream)
+            return 0;
+    }
+
+    // stdout carries the audio here, so everything else goes to stderr.
+    if (stream)
+    {
+        streamOptions.blockSize = blockSize;
+        PcmStream pcmStream(settings, streamOptions);
+
+        auto error = pcmStream.prepare();
+
+        if (error.isNotEmpty())
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+
+        auto latency = pcmStream.getAddedLatencyFrames();
+        std::cerr << "streaming " << streamOptions.numChannels << " channels of "
+                  << PcmStream::getSampleFormatNames()[(int) streamOptions.format] << " at "
+                  << String(streamOptions.sampleRate, 0) << " Hz, added latency " << latency << " frames ("
+                  << String(1000.0 * latency / streamOptions.sampleRate, 2) << " ms)" << std::endl;
+
+        auto result = pcmStream.run();
+
+        std::cerr << result.numFrames << " frames in " << result.numBlocks << " blocks, "
+                  << result.numParameterChanges << " parameter changes, block processing mean "
+                  << String(result.meanBlockMilliseconds, 3) << " ms, max "
+                  << String(result.maxBlockMilliseconds, 3) << " ms" << std::endl;
+
+        if (result.error.isNotEmpty())
+        {
+            std::cerr << result.error << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (inputs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (outputDirectory != File())
+        outputDirectory.createDirectory();
+
+    Array<BatchRenderer::Task> tasks;
+
+    for (auto& input : inputs)
+    {
+        auto extension = outputFormat.isNotEmpty() ? "." + outputFormat : input.getFileExtension();
+        auto name = input.getFileNameWithoutExtension();
+
+        if (outputDirectory != File())
+            tasks.add({ input, outputDirectory.getChildFile(name + extension) });
+        else
+            tasks.add({ input, input.getSiblingFile(name + "_boosted" + extension) });
+    }
+
+    if (segmentSeconds > 0.0)
+    {
+        if (traceFile != File())
+        {
+            std::cerr << "--trace is not supported with --segment" << std::endl;
+            return 1;
+        }
+
+        SegmentedRenderer renderer(settings, blockSize, bitDepth, segmentSeconds);
+        int numFailed = 0;
+
+        for (auto& task : tasks)
+        {
+            auto result = renderer.render(task, numJobs, checkSerial);
+
+            if (result.error.isNotEmpty())
+            {
+                std::cerr << "FAILED " << result.error << std::endl;
+                ++numFailed;
+                continue;
+            }
+
+            std::cout << task.output.getFileName() << ": "
+                      << String(result.audioSeconds, 1) << " s audio in "
+                      << String(result.wallSeconds, 3) << " s ("
+                      << String(result.getRealtimeMultiple(), 1) << "x realtime), "
+                      << result.numSegments << " segments on " << numJobs << " workers, "
+                      << String(result.warmUpSeconds, 2) << " s warm-up" << std::endl;
+
+            if (result.checkedSerial)
+            {
+                std::cout << "  serial check: " << (result.isWithinTolerance() ? "ok" : "FAILED")
+                          << ", max difference " << String(result.serialErrorDecibels, 1) << " dB (tolerance "
+                          << String(result.serialToleranceDecibels, 1) << " dB)" << std::endl;
+
+                if (! result.isWithinTolerance())
+                    ++numFailed;
+            }
+        }
+
+        return numFailed == 0 ? 0 : 1;
+    }
+
+    BatchRenderer renderer(settings, blockSize, bitDepth);
+
+    if (traceFile != File())
+    {
+       #if DAMNBASSBOOST_PROFILE_STAGES
+        renderer.setProfileStages(true);
+       #else
+        std::cerr << "--trace needs a build with DAMNBASSBOOST_PROFILE_STAGES=1" << std::endl;
+        return 1;
+       #endif
+    }
+
+    auto startTime = Time::getMillisecondCounterHiRes();
+    auto results = renderer.render(tasks, numJobs);
+    auto wallSeconds = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    double audioSeconds = 0.0;
+    int numFailed = 0;
+
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        auto& result = results[(size_t) i];
+
+        if (result.error.isNotEmpty())
+        {
+            std::cerr << "FAILED " << result.error << std::endl;
+            ++numFailed;
+            continue;
+        }
+
+        audioSeconds += result.audioSeconds;
+
+        std::cout << tasks[i].output.getFileName() << ": "
+                  << String(result.audioSeconds, 1) << " s audio in "
+                  << String(result.wallSeconds, 3) << " s ("
+                  << String(result.getRealtimeMultiple(), 1) << "x realtime)" << std::endl;
+    }
+
+    auto numWorkers = jmin(numJobs, tasks.size());
+
+    std::cout << std::endl
+              << tasks.size() - numFailed << " of " << tasks.size() << " files, "
+              << String(audioSeconds, 1) << " s audio in " << String(wallSeconds, 3) << " s on "
+              << numWorkers << " workers: "
+              << String(wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0, 1) << "x realtime total, "
+              << String(wallSeconds > 0.0 ? audioSeconds / wallSeconds / numWorkers : 0.0, 1) << "x per worker" << std::endl;
+
+   #if DAMNBASSBOOST_PROFILE_STAGES
+    if (traceFile != File())
+    {
+        for (int i = 0; i < renderer.getStageSummaries().size(); ++i)
+            std::cout << std::endl << "worker " << i + 1 << std::endl << renderer.getStageSummaries()[i];
+
+        traceFile.deleteFile();
+        FileOutputStream out(traceFile);
+
+        if (! out.openedOk())
+        {
+            std::cerr << "Cannot write " << traceFile.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        StageProfiler::writeChromeTrace(out, renderer.getStageTracks(), renderer.getCyclesPerMicrosecond());
+    }
+   #endif
+
+    return numFailed == 0 ? 0 : 1;
+}
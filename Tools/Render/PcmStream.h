@@ -0,0 +1,415 @@
+#pragma once
+
+#include "../Common/HostUtil.h"
+
+#include <iostream>
+
+#if ! JUCE_WINDOWS
+ #include <cerrno>
+ #include <cstring>
+ #include <csignal>
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+// Streams raw interleaved little-endian PCM from one file descriptor through a
+// PluginAudioProcessor to another, for pipelines that connect processes with
+// pipes (e.g. `ffmpeg ... -f s16le - | DamnBassBoostRender --stream ... | ...`).
+//
+// Input accumulates in a buffer of one block, which is converted straight into
+// the processor's channel buffers and processed once full; the processed
+// channels are converted straight into the output block and written. The added
+// latency is therefore exactly one block plus the processor's own latency.
+//
+// Parameter changes come as "<id>=<value>" lines from a control file or named
+// pipe, read on a separate thread and handed to the audio loop through a
+// lock-free queue; the loop applies them between blocks and never waits for
+// the control side.
+class PcmStream
+{
+public:
+    enum class SampleFormat
+    {
+        float32,
+        int16,
+        int24,
+        int32,
+    };
+
+    static StringArray getSampleFormatNames()
+    {
+        return { "f32", "s16", "s24", "s32" };
+    }
+
+    static bool parseSampleFormat(const String& text, SampleFormat& result)
+    {
+        auto index = getSampleFormatNames().indexOf(text.trim(), true);
+
+        if (index < 0)
+            return false;
+
+        result = (SampleFormat) index;
+        return true;
+    }
+
+    static int getBytesPerSample(SampleFormat format)
+    {
+        static const int bytes[] = { 4, 2, 3, 4 };
+        return bytes[(size_t) format];
+    }
+
+    struct Options
+    {
+        double sampleRate = 48000.0;
+        int numChannels = 2;
+        SampleFormat format = SampleFormat::float32;
+        int blockSize = 512;
+        int inputDescriptor = 0;
+        int outputDescriptor = 1;
+        File controlFile;
+    };
+
+    struct Result
+    {
+        int64 numFrames = 0;
+        int64 numBlocks = 0;
+        int numParameterChanges = 0;
+        double wallSeconds = 0.0;
+
+        // Processing time of one block, from a full input block to its output
+        // handed to the output descriptor.
+        double meanBlockMilliseconds = 0.0;
+        double maxBlockMilliseconds = 0.0;
+
+        String error;
+    };
+
+    PcmStream(const HostUtil::ProcessorSettings& settingsToUse, const Options& optionsToUse)
+        : settings(settingsToUse), options(optionsToUse)
+    {
+    }
+
+    // Frames between a frame entering the input and its processed result
+    // leaving: the input block plus the latency the processor reports.
+    int getAddedLatencyFrames() const noexcept
+    {
+        return options.blockSize + processor.getLatencySamples();
+    }
+
+    // Prepares the processor; call before run() and getAddedLatencyFrames().
+    String prepare()
+    {
+        auto error = HostUtil::applySettings(processor, settings);
+
+        if (error.isEmpty() && ! HostUtil::setChannelLayout(processor, options.numChannels))
+            error = "Unsupported channel count (" + String(options.numChannels) + ")";
+
+        if (error.isNotEmpty())
+            return error;
+
+        processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+        processor.prepareToPlay(options.sampleRate, options.blockSize);
+        return {};
+    }
+
+    // Processes until the input ends or the output is closed.
+    Result run()
+    {
+        Result result;
+
+       #if JUCE_WINDOWS
+        result.error = "Streaming needs a POSIX system";
+       #else
+        const auto frameBytes = options.numChannels * getBytesPerSample(options.format);
+        const auto blockBytes = (size_t) (options.blockSize * frameBytes);
+
+        HeapBlock<char> inputBlock(blockBytes), outputBlock(blockBytes);
+        AudioBuffer<float> buffer(options.numChannels, options.blockSize);
+        MidiBuffer midi;
+
+        // A closed reader downstream shows up as EPIPE from write() instead.
+        std::signal(SIGPIPE, SIG_IGN);
+
+        std::unique_ptr<ControlReader> controlReader;
+
+        if (options.controlFile != File())
+        {
+            controlReader = std::make_unique<ControlReader>(*this, options.controlFile);
+
+            if (! controlReader->open())
+            {
+                result.error = "Cannot open control file " + options.controlFile.getFullPathName();
+                return result;
+            }
+
+            controlReader->startThread();
+        }
+
+        const auto startTime = Time::getMillisecondCounterHiRes();
+        double totalBlockMilliseconds = 0.0;
+
+        for (;;)
+        {
+            size_t numBytes = 0;
+
+            if (! readFully(options.inputDescriptor, inputBlock.get(), blockBytes, numBytes))
+            {
+                result.error = "Read failed: " + String(std::strerror(errno));
+                break;
+            }
+
+            const auto numFrames = (int) (numBytes / (size_t) frameBytes);
+
+            if (numFrames == 0)
+                break;
+
+            const auto blockStart = Time::getMillisecondCounterHiRes();
+
+            result.numParameterChanges += applyParameterChanges();
+
+            AudioBuffer<float> block(buffer.getArrayOfWritePointers(), options.numChannels, numFrames);
+            convert(inputBlock.get(), block, true);
+            processor.processBlock(block, midi);
+            convert(outputBlock.get(), block, false);
+
+            if (! writeFully(options.outputDescriptor, outputBlock.get(), (size_t) (numFrames * frameBytes)))
+            {
+                if (errno != EPIPE)
+                    result.error = "Write failed: " + String(std::strerror(errno));
+
+                break;
+            }
+
+            const auto blockMilliseconds = Time::getMillisecondCounterHiRes() - blockStart;
+            totalBlockMilliseconds += blockMilliseconds;
+            result.maxBlockMilliseconds = jmax(result.maxBlockMilliseconds, blockMilliseconds);
+
+            result.numFrames += numFrames;
+            ++result.numBlocks;
+
+            if ((size_t) (numFrames * frameBytes) != numBytes || numFrames < options.blockSize)
+                break; // end of input, possibly with a partial frame that is dropped
+        }
+
+        if (controlReader != nullptr)
+            controlReader->stopThread(1000);
+
+        result.wallSeconds = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+        result.meanBlockMilliseconds = result.numBlocks > 0 ? totalBlockMilliseconds / (double) result.numBlocks : 0.0;
+       #endif
+
+        return result;
+    }
+
+private:
+    //==============================================================================
+    struct ParameterChange
+    {
+        RangedAudioParameter* parameter = nullptr;
+        float value = 0.0f;
+    };
+
+    // Audio loop: applies the queued changes, returns how many.
+    int applyParameterChanges()
+    {
+        const auto scope = changeFifo.read(changeFifo.getNumReady());
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            apply(changes[(size_t) (scope.startIndex1 + i)]);
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            apply(changes[(size_t) (scope.startIndex2 + i)]);
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    static void apply(const ParameterChange& change)
+    {
+        change.parameter->setValueNotifyingHost(change.value);
+    }
+
+    // Control thread: false if the queue is full.
+    bool queueParameterChange(const HostUtil::ParameterSetting& setting)
+    {
+        auto* parameter = HostUtil::findParameter(processor, setting.id);
+
+        if (parameter == nullptr)
+        {
+            std::cerr << "Unknown parameter in control input: " << setting.id << std::endl;
+            return true;
+        }
+
+        const auto scope = changeFifo.write(1);
+
+        if (scope.blockSize1 == 0)
+            return false;
+
+        changes[(size_t) scope.startIndex1] = { parameter, parameter->convertTo0to1(setting.value) };
+        return true;
+    }
+
+    //==============================================================================
+    // Interleaved little-endian PCM of one format to and from the float
+    // channels, one channel at a time with the interleaved stride.
+    template <typename Format>
+    static void convertFormat(char* interleaved, AudioBuffer<float>& channels, bool toChannels)
+    {
+        using Interleaved = AudioData::Pointer<Format, AudioData::LittleEndian, AudioData::Interleaved, AudioData::NonConst>;
+        using Channel = AudioData::Pointer<AudioData::Float32, AudioData::NativeEndian, AudioData::NonInterleaved, AudioData::NonConst>;
+
+        const auto numChannels = channels.getNumChannels();
+        const auto sampleBytes = Interleaved::getBytesPerSample();
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            Interleaved pcm(interleaved + ch * sampleBytes, numChannels);
+            Channel channel(channels.getWritePointer(ch));
+
+            if (toChannels)
+                channel.convertSamples(pcm, channels.getNumSamples());
+            else
+                pcm.convertSamples(channel, channels.getNumSamples());
+        }
+    }
+
+    void convert(char* interleaved, AudioBuffer<float>& channels, bool toChannels) const
+    {
+        switch (options.format)
+        {
+            case SampleFormat::float32: convertFormat<AudioData::Float32>(interleaved, channels, toChannels); break;
+            case SampleFormat::int16:   convertFormat<AudioData::Int16>  (interleaved, channels, toChannels); break;
+            case SampleFormat::int24:   convertFormat<AudioData::Int24>  (interleaved, channels, toChannels); break;
+            case SampleFormat::int32:   convertFormat<AudioData::Int32>  (interleaved, channels, toChannels); break;
+        }
+    }
+
+   #if ! JUCE_WINDOWS
+    // Reads until the block is full or the input ends; pipes return partial reads.
+    static bool readFully(int descriptor, char* data, size_t size, size_t& numRead)
+    {
+        numRead = 0;
+
+        while (numRead < size)
+        {
+            auto n = ::read(descriptor, data + numRead, size - numRead);
+
+            if (n > 0)
+                numRead += (size_t) n;
+            else if (n == 0)
+                break;
+            else if (errno != EINTR)
+                return false;
+        }
+
+        return true;
+    }
+
+    static bool writeFully(int descriptor, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            auto n = ::write(descriptor, data, size);
+
+            if (n >= 0)
+            {
+                data += n;
+                size -= (size_t) n;
+            }
+            else if (errno != EINTR)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    // Polls the control file for new "<id>=<value>" lines. It is opened
+    // non-blocking, so a named pipe needs no writer yet, and a regular file is
+    // followed as lines are appended. Empty lines and lines starting with '#'
+    // are ignored.
+    class ControlReader : public Thread
+    {
+    public:
+        ControlReader(PcmStream& o, const File& f) : Thread("PcmStream control"), owner(o), file(f) {}
+
+        ~ControlReader() override
+        {
+            stopThread(1000);
+
+            if (descriptor >= 0)
+                ::close(descriptor);
+        }
+
+        bool open()
+        {
+            descriptor = ::open(file.getFullPathName().toRawUTF8(), O_RDONLY | O_NONBLOCK);
+            return descriptor >= 0;
+        }
+
+        void run() override
+        {
+            char chunk[512];
+
+            while (! threadShouldExit())
+            {
+                auto n = ::read(descriptor, chunk, sizeof(chunk));
+
+                if (n > 0)
+                {
+                    pending.append(chunk, (size_t) n);
+                    parseLines();
+                }
+                else if (n == 0 || errno == EAGAIN || errno == EINTR)
+                {
+                    wait(20);
+                }
+                else
+                {
+                    std::cerr << "Control input failed: " << std::strerror(errno) << std::endl;
+                    break;
+                }
+            }
+        }
+
+    private:
+        void parseLines()
+        {
+            for (auto end = pending.find('\n'); end != std::string::npos; end = pending.find('\n'))
+            {
+                auto line = String(CharPointer_UTF8(pending.substr(0, end).c_str())).trim();
+                pending.erase(0, end + 1);
+
+                if (line.isEmpty() || line.startsWithChar('#'))
+                    continue;
+
+                HostUtil::ParameterSetting setting;
+
+                if (! HostUtil::parseParameterSetting(line, setting))
+                    std::cerr << "Expected <id>=<value> in control input: " << line << std::endl;
+                else if (! owner.queueParameterChange(setting))
+                    std::cerr << "Control queue full, dropped: " << line << std::endl;
+            }
+        }
+
+        PcmStream& owner;
+        File file;
+        int descriptor = -1;
+        std::string pending;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ControlReader)
+    };
+   #endif
+
+    HostUtil::ProcessorSettings settings;
+    Options options;
+    PluginAudioProcessor processor;
+
+    static constexpr int changeCapacity = 256;
+    AbstractFifo changeFifo { changeCapacity };
+    std::array<ParameterChange, (size_t) changeCapacity> changes;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PcmStream)
+};
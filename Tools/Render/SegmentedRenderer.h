@@ -0,0 +1,315 @@
+#pragma once
+
+#include "BatchRenderer.h"
+
+//==============================================================================
+// Renders one long file on several cores. The file is cut into segments that
+// workers process in parallel, each through its own PluginAudioProcessor. A
+// segment's processor first runs over the audio just before the segment,
+// long enough for the detector, the ladder filter and the parameter and mix
+// smoothing to forget where they started (see getWarmUpSeconds()), so it
+// enters the segment in the state a serial render would have. The first
+// segment needs no warm-up, as a serial render starts from the same fresh
+// processor. With latency, as BatchRenderer does, output sample t is the
+// processed sample t + latency: each segment is processed that far past its
+// end, rounded up to a whole block, or to the end of the serial render's
+// tail. The calling thread writes the segments in order as they finish.
+// A worker starts segment N only once segment N - numWorkers is written, so
+// however the workers' speeds differ, at most numWorkers rendered segments
+// wait in memory, besides the one each worker is rendering.
+class SegmentedRenderer
+{
+public:
+    struct Result : public BatchRenderer::Result
+    {
+        int numSegments = 0;
+        double warmUpSeconds = 0.0;
+
+        // With checkSerial: the largest difference from a serial render of the
+        // same file, against -100 dBFS or one LSB of the output format,
+        // whichever is larger.
+        bool checkedSerial = false;
+        double serialErrorDecibels = -400.0;
+        double serialToleranceDecibels = 0.0;
+
+        bool isWithinTolerance() const { return ! checkedSerial || serialErrorDecibels <= serialToleranceDecibels; }
+    };
+
+    SegmentedRenderer(const HostUtil::ProcessorSettings& settingsToUse, int blockSizeToUse, int bitDepthToUse, double segmentSecondsToUse)
+        : settings(settingsToUse), blockSize(blockSizeToUse), bitDepth(bitDepthToUse), segmentSeconds(segmentSecondsToUse)
+    {
+        formatManager.registerBasicFormats();
+    }
+
+    // The processor's -120 dB tail for its speed and boostFreq, plus the 50 ms
+    // cutoff and dry/wet smoothing and the 20 ms parameter ramp, with margin.
+    static double getWarmUpSeconds(const PluginAudioProcessor& processor)
+    {
+        return processor.getTailLengthSeconds() + 0.1;
+    }
+
+    Result render(const BatchRenderer::Task& task, int numWorkers, bool checkSerial)
+    {
+        Result result;
+        auto startTime = Time::getMillisecondCounterHiRes();
+
+        std::unique_ptr<AudioFormatReader> reader(formatManager.createReaderFor(task.input));
+
+        if (reader == nullptr)
+        {
+            result.error = "Cannot read " + task.input.getFullPathName();
+            return result;
+        }
+
+        sampleRate = reader->sampleRate;
+        numChannels = (int) reader->numChannels;
+        length = reader->lengthInSamples;
+
+        // Processors are created and destroyed on this thread; the workers only process.
+        OwnedArray<SegmentWorker> workers;
+        numWorkers = jmax(1, numWorkers);
+
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            auto processor = std::make_unique<PluginAudioProcessor>();
+            result.error = HostUtil::applySettings(*processor, settings);
+
+            if (result.error.isEmpty() && ! HostUtil::setChannelLayout(*processor, numChannels))
+                result.error = "Unsupported channel count (" + String(numChannels) + ") in " + task.input.getFileName();
+
+            if (result.error.isNotEmpty())
+                return result;
+
+            workers.add(new SegmentWorker(*this, task.input, std::move(processor)));
+        }
+
+        // Segment and warm-up lengths in whole blocks, so every block starts
+        // where it would in a serial render.
+        auto toBlocks = [this](double seconds) { return jmax((int64) 1, (int64) std::ceil(seconds * sampleRate / blockSize)) * blockSize; };
+
+        // Latency is known once prepared; the workers prepare again per segment.
+        auto& firstProcessor = workers[0]->getProcessor();
+        firstProcessor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        firstProcessor.prepareToPlay(sampleRate, blockSize);
+        latency = (int64) firstProcessor.getLatencySamples();
+        firstProcessor.releaseResources();
+
+        result.warmUpSeconds = getWarmUpSeconds(firstProcessor);
+        warmUpLength = toBlocks(result.warmUpSeconds);
+        segmentLength = jmax(toBlocks(segmentSeconds), warmUpLength);
+
+        segments.clear();
+
+        for (int64 start = 0; start < length; start += segmentLength)
+            segments.push_back(std::make_unique<Segment>(start, jmin(segmentLength, length - start)));
+
+        result.numSegments = (int) segments.size();
+        nextSegment = 0;
+        maxSegmentsAhead = numWorkers;
+
+        auto writer = BatchRenderer::createWriter(formatManager, task, *reader, bitDepth, result.error);
+
+        if (writer == nullptr)
+            return result;
+
+        const auto bits = writer->getBitsPerSample();
+        const auto isFloat = writer->isFloatingPoint();
+
+        ThreadPool pool(numWorkers);
+
+        for (auto* worker : workers)
+            pool.addJob(worker, false);
+
+        for (auto& segment : segments)
+        {
+            segment->finished.wait(-1);
+
+            if (segment->error.isNotEmpty() && result.error.isEmpty())
+                result.error = segment->error;
+
+            if (result.error.isEmpty())
+                writer->writeFromAudioSampleBuffer(segment->output, 0, segment->output.getNumSamples());
+
+            segment->output.setSize(0, 0);
+            segment->written.signal();
+        }
+
+        for (auto* worker : workers)
+            pool.waitForJobToFinish(worker, -1);
+
+        writer.reset();
+
+        result.wallSeconds = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+        result.audioSeconds = (double) length / sampleRate;
+
+        if (checkSerial && result.error.isEmpty())
+        {
+            result.checkedSerial = true;
+            result.serialToleranceDecibels = Decibels::gainToDecibels(jmax(1.0e-5, isFloat ? 0.0 : std::ldexp(1.0, 1 - bits)), -400.0);
+            result.serialErrorDecibels = compareWithSerial(task, *reader, result.error);
+        }
+
+        return result;
+    }
+
+private:
+    //==============================================================================
+    struct Segment
+    {
+        Segment(int64 s, int64 l) : start(s), length(l) {}
+
+        int64 start, length;
+        AudioBuffer<float> output;
+        String error;
+        WaitableEvent finished { true }, written { true };
+    };
+
+    class SegmentWorker : public ThreadPoolJob
+    {
+    public:
+        SegmentWorker(SegmentedRenderer& o, const File& input, std::unique_ptr<PluginAudioProcessor> p)
+            : ThreadPoolJob("SegmentWorker"), owner(o), processor(std::move(p))
+        {
+            formatManager.registerBasicFormats();
+            reader.reset(formatManager.createReaderFor(input));
+        }
+
+        PluginAudioProcessor& getProcessor() noexcept { return *processor; }
+
+        JobStatus runJob() override
+        {
+            for (;;)
+            {
+                auto index = owner.nextSegment++;
+
+                if (index >= (int) owner.segments.size() || shouldExit())
+                    break;
+
+                auto& segment = *owner.segments[(size_t) index];
+
+                if (index >= owner.maxSegmentsAhead)
+                    owner.segments[(size_t) (index - owner.maxSegmentsAhead)]->written.wait(-1);
+
+                if (reader == nullptr)
+                    segment.error = "Cannot read the input on a worker";
+                else
+                    renderSegment(segment);
+
+                segment.finished.signal();
+            }
+
+            return jobHasFinished;
+        }
+
+    private:
+        // prepareToPlay() starts the processor from scratch, as a serial render
+        // does; segment 0 has nothing before it and so gets no warm-up. Blocks
+        // start where the serial render's do, and the last one ends where
+        // it would too: at a block boundary or at the end of the tail.
+        void renderSegment(Segment& segment)
+        {
+            const auto warmUpStart = jmax((int64) 0, segment.start - owner.warmUpLength);
+            const auto blockSize = (int64) owner.blockSize;
+            const auto end = jmin((segment.start + segment.length + owner.latency + blockSize - 1) / blockSize * blockSize,
+                                  owner.length + owner.latency);
+            const auto total = (int) (end - warmUpStart);
+
+            AudioBuffer<float> buffer(owner.numChannels, total);
+            reader->read(&buffer, 0, total, warmUpStart, true, true);
+
+            processor->setRateAndBufferSizeDetails(owner.sampleRate, owner.blockSize);
+            processor->prepareToPlay(owner.sampleRate, owner.blockSize);
+
+            MidiBuffer midi;
+
+            for (int start = 0; start < total; start += owner.blockSize)
+            {
+                AudioBuffer<float> block(buffer.getArrayOfWritePointers(), owner.numChannels, start, jmin(owner.blockSize, total - start));
+                processor->processBlock(block, midi);
+            }
+
+            processor->releaseResources();
+
+            const auto offset = (int) (segment.start + owner.latency - warmUpStart);
+            segment.output.setSize(owner.numChannels, (int) segment.length);
+
+            for (int ch = 0; ch < owner.numChannels; ++ch)
+                segment.output.copyFrom(ch, 0, buffer, ch, offset, (int) segment.length);
+        }
+
+        SegmentedRenderer& owner;
+        std::unique_ptr<PluginAudioProcessor> processor;
+        AudioFormatManager formatManager;
+        std::unique_ptr<AudioFormatReader> reader;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SegmentWorker)
+    };
+
+    // Renders the input serially, with the latency trimmed as BatchRenderer
+    // does, and compares it with the written output, block by block.
+    double compareWithSerial(const BatchRenderer::Task& task, AudioFormatReader& input, String& error)
+    {
+        std::unique_ptr<AudioFormatReader> output(formatManager.createReaderFor(task.output));
+
+        if (output == nullptr)
+        {
+            error = "Cannot read back " + task.output.getFullPathName();
+            return 0.0;
+        }
+
+        PluginAudioProcessor processor;
+        HostUtil::applySettings(processor, settings);
+        HostUtil::setChannelLayout(processor, numChannels);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        const auto serialLatency = (int64) processor.getLatencySamples();
+        const auto total = length + serialLatency;
+
+        AudioBuffer<float> serial(numChannels, blockSize), written(numChannels, blockSize);
+        MidiBuffer midi;
+        float largestError = 0.0f;
+
+        for (int64 position = 0; position < total; position += blockSize)
+        {
+            auto numSamples = (int) jmin((int64) blockSize, total - position);
+
+            serial.setSize(numChannels, numSamples, false, false, true);
+            input.read(&serial, 0, numSamples, position, true, true);
+            processor.processBlock(serial, midi);
+
+            const auto skip = (int) jlimit((int64) 0, (int64) numSamples, serialLatency - position);
+            const auto numCompared = numSamples - skip;
+
+            if (numCompared == 0)
+                continue;
+
+            written.setSize(numChannels, numCompared, false, false, true);
+            output->read(&written, 0, numCompared, position + skip - serialLatency, true, true);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                FloatVectorOperations::subtract(written.getWritePointer(ch), serial.getReadPointer(ch, skip), numCompared);
+                largestError = jmax(largestError, written.getMagnitude(ch, 0, numCompared));
+            }
+        }
+
+        return Decibels::gainToDecibels((double) largestError, -400.0);
+    }
+
+    HostUtil::ProcessorSettings settings;
+    int blockSize;
+    int bitDepth;
+    double segmentSeconds;
+    AudioFormatManager formatManager;
+
+    double sampleRate = 44100.0;
+    int numChannels = 0;
+    int64 length = 0, segmentLength = 0, warmUpLength = 0, latency = 0;
+
+    std::vector<std::unique_ptr<Segment>> segments;
+    std::atomic<int> nextSegment { 0 };
+    int maxSegmentsAhead = 1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SegmentedRenderer)
+};